@@ -11,11 +11,9 @@ namespace ImageMorphing {
     return 0;
   }
 
-  ApplicationForm::ApplicationForm() {
+  ApplicationForm::ApplicationForm() : result_render_(nullptr), is_closing_after_render_(false), preview_frames_(new std::vector<cv::Mat>()), shown_preview_frame_data_(nullptr) {
     InitializeComponent();
 
-    InitializeOpenGL();
-
     picture_boxes = gcnew System::Collections::Generic::List<System::Windows::Forms::PictureBox ^>();
 
     add_images_tool_strip_menu_item_->Click += gcnew System::EventHandler(this, &ImageMorphing::ApplicationForm::OnButtonsClick);
@@ -25,157 +23,26 @@ namespace ImageMorphing {
     load_features_button_->Click += gcnew System::EventHandler(this, &ImageMorphing::ApplicationForm::OnButtonsClick);
     save_features_button_->Click += gcnew System::EventHandler(this, &ImageMorphing::ApplicationForm::OnButtonsClick);
 
+    this->FormClosing += gcnew System::Windows::Forms::FormClosingEventHandler(this, &ImageMorphing::ApplicationForm::OnFormClosing);
+
     srand(time(0));
 
     //Test();
   }
 
   ApplicationForm::~ApplicationForm() {
-    if (components) {
-      delete components;
-    }
-  }
-
-  bool ApplicationForm::ParseFileIntoString(const std::string &file_path, std::string &file_string) {
-    std::ifstream file_stream(file_path);
-    if (!file_stream.is_open()) {
-      return false;
-    }
-    file_string = std::string(std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>());
-    return true;
-  }
-
-  void ApplicationForm::InitializeOpenGL() {
-    // Get Handle
-    hwnd = (HWND)this->Handle.ToPointer();
-    hdc = GetDC(hwnd);
-    wglSwapBuffers(hdc);
-
-    // Set pixel format
-    PIXELFORMATDESCRIPTOR pfd;
-    pfd.nVersion = 1;
-    pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-    pfd.iPixelType = (byte)(PFD_TYPE_RGBA);
-    pfd.cColorBits = 32;
-    pfd.cDepthBits = 32;
-    pfd.iLayerType = (byte)(PFD_MAIN_PLANE);
-
-    SetPixelFormat(hdc, ChoosePixelFormat(hdc, &pfd), &pfd);
-
-    // Create OpenGL Rendering Context
-    hrc = (wglCreateContext(hdc));
-    if (!hrc) {
-      std::cerr << "wglCreateContext failed.\n";
-    }
-
-    // Assign OpenGL Rendering Context
-    if (!wglMakeCurrent(hdc, hrc)) {
-      std::cerr << "wglMakeCurrent failed.\n";
-    }
-
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-      std::cerr << "OpenGL initialize failed.\n";
-    }
-
-    if (!GLEW_VERSION_2_0) {
-      std::cerr << "Your graphic card does not support OpenGL 2.0.\n";
-    }
-
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    std::string vertex_shader_string;
-    std::string fragment_shader_string;
-
-    ParseFileIntoString(DEFAULT_VERTEX_SHADER_FILE_PATH, vertex_shader_string);
-    ParseFileIntoString(DEFAULT_FRAGMENT_SHADER_FILE_PATH, fragment_shader_string);
-
-    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    const GLchar *vertex_shader_pointer = (const GLchar*)vertex_shader_string.c_str();
-    glShaderSource(vertex_shader, 1, &vertex_shader_pointer, NULL);
-    glCompileShader(vertex_shader);
-
-    int shader_compile_status;
-    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &shader_compile_status);
-    if (shader_compile_status != GL_TRUE) {
-      std::cerr << "Could not compile the shader " << DEFAULT_VERTEX_SHADER_FILE_PATH << " .\n";
-    }
-
-    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    const GLchar *fragment_shader_pointer = (const GLchar*)fragment_shader_string.c_str();
-    glShaderSource(fragment_shader, 1, &fragment_shader_pointer, NULL);
-    glCompileShader(fragment_shader);
-
-    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &shader_compile_status);
-    if (shader_compile_status != GL_TRUE) {
-      std::cerr << "Could not compile the shader " << DEFAULT_FRAGMENT_SHADER_FILE_PATH << " .\n";
-    }
-
-    shader_program_id = glCreateProgram();
-    glAttachShader(shader_program_id, vertex_shader);
-    glAttachShader(shader_program_id, fragment_shader);
-    glLinkProgram(shader_program_id);
-
-    int shader_link_status;
-    glGetProgramiv(shader_program_id, GL_LINK_STATUS, &shader_link_status);
-    if (shader_link_status != GL_TRUE) {
-      std::cerr << "Could not link the shader.\n";
+    // OnFormClosing keeps the form open until a render is done, this only covers a form destroyed without closing
+    if (result_thread_) {
+      result_render_->sequence_renderer_.Cancel();
+      result_thread_->Join();
     }
 
-    int shader_validate_status;
-    glValidateProgram(shader_program_id);
-    glGetProgramiv(shader_program_id, GL_VALIDATE_STATUS, &shader_validate_status);
-    if (shader_validate_status != GL_TRUE) {
-      std::cerr << "Could not validate the shader.\n";
-    }
-
-    shader_attribute_vertex_position_id = glGetAttribLocation(shader_program_id, SHADER_ATTRIBUTE_VERTEX_POSITION_NAME.c_str());
-    if (shader_attribute_vertex_position_id == -1) {
-      std::cerr << "Could not bind attribute " << SHADER_ATTRIBUTE_VERTEX_POSITION_NAME << ".\n";
-    }
-
-    shader_attribute_vertex_color_id = glGetAttribLocation(shader_program_id, SHADER_ATTRIBUTE_VERTEX_COLOR_NAME.c_str());
-    if (shader_attribute_vertex_color_id == -1) {
-      std::cerr << "Could not bind attribute " << SHADER_ATTRIBUTE_VERTEX_COLOR_NAME << ".\n";
-    }
-
-    shader_attribute_vertex_uv_id = glGetAttribLocation(shader_program_id, SHADER_ATTRIBUTE_VERTEX_UV_NAME.c_str());
-    if (shader_attribute_vertex_uv_id == -1) {
-      std::cerr << "Could not bind attribute " << SHADER_ATTRIBUTE_VERTEX_UV_NAME << ".\n";
-    }
-
-    shader_uniform_modelview_matrix_id = glGetUniformLocation(shader_program_id, SHADER_UNIFORM_MODELVIEW_MATRIX_NAME.c_str());
-    if (shader_uniform_modelview_matrix_id == -1) {
-      std::cerr << "Could not bind uniform " << SHADER_UNIFORM_MODELVIEW_MATRIX_NAME << ".\n";
-    }
-
-    shader_uniform_view_matrix_id = glGetUniformLocation(shader_program_id, SHADER_UNIFORM_VIEW_MATRIX_NAME.c_str());
-    if (shader_uniform_view_matrix_id == -1) {
-      std::cerr << "Could not bind uniform " << SHADER_UNIFORM_VIEW_MATRIX_NAME << ".\n";
-    }
-
-    shader_uniform_projection_matrix_id = glGetUniformLocation(shader_program_id, SHADER_UNIFORM_PROJECTION_MATRIX_NAME.c_str());
-    if (shader_uniform_projection_matrix_id == -1) {
-      std::cerr << "Could not bind uniform " << SHADER_UNIFORM_PROJECTION_MATRIX_NAME << ".\n";
-    }
-
-    shader_uniform_texture_id = glGetUniformLocation(shader_program_id, SHADER_UNIFORM_TEXTURE_NAME.c_str());
-    if (shader_uniform_texture_id == -1) {
-      std::cerr << "Could not bind uniform " << SHADER_UNIFORM_TEXTURE_NAME << ".\n";
-    }
+    delete result_render_;
+    delete preview_frames_;
 
-    shader_uniform_texture_flag_id = glGetUniformLocation(shader_program_id, SHADER_UNIFORM_TEXTURE_FLAG_NAME.c_str());
-    if (shader_uniform_texture_flag_id == -1) {
-      std::cerr << "Could not bind uniform " << SHADER_UNIFORM_TEXTURE_FLAG_NAME << ".\n";
+    if (components) {
+      delete components;
     }
-
-    glUseProgram(shader_program_id);
   }
 
   void ApplicationForm::OnButtonsClick(System::Object ^sender, System::EventArgs ^e) {
@@ -280,6 +147,11 @@ namespace ImageMorphing {
   }
 
   void ApplicationForm::AddImage(System::String ^file_path) {
+    if (!image_store.Load(msclr::interop::marshal_as<std::string>(file_path))) {
+      std::cerr << "Could not read image " << msclr::interop::marshal_as<std::string>(file_path) << ".\n";
+      return;
+    }
+
     System::Windows::Forms::PictureBox ^new_picture_box = gcnew System::Windows::Forms::PictureBox();
 
     new_picture_box->SizeMode = System::Windows::Forms::PictureBoxSizeMode::AutoSize;
@@ -290,50 +162,31 @@ namespace ImageMorphing {
 
     picture_boxes->Add(new_picture_box);
 
-    source_images.resize(picture_boxes->Count);
-    resized_images.resize(picture_boxes->Count);
     images_with_feature_lines.resize(picture_boxes->Count);
     feature_lines_of_images.resize(picture_boxes->Count);
     last_feature_line_of_images.resize(picture_boxes->Count);
     is_drawing_feature_of_images.resize(picture_boxes->Count);
 
-    Bitmap ^source_bitmap = gcnew Bitmap(file_path);
-    new_picture_box->Image = source_bitmap;
-
-    source_images[source_images.size() - 1] = cv::imread(msclr::interop::marshal_as<std::string>(file_path));
+    // The bitmap comes from the decoded pixels, the file is not decoded a second time
+    new_picture_box->Image = CVMatToBitmap(image_store.Image(image_store.ImageCount() - 1));
 
     if (picture_boxes->Count >= 2) {
       start_button_->Enabled = true;
     }
 
-    AdjustImagesSize();
+    LayoutPictureBoxes();
   }
 
-  void ApplicationForm::AdjustImagesSize() {
+  void ApplicationForm::LayoutPictureBoxes() {
     if (!picture_boxes->Count) {
       return;
     }
 
-    cv::Size min_size = source_images[0].size();
-
-    for (const cv::Mat &image : source_images) {
-      min_size.width = std::min(min_size.width, image.size().width);
-      min_size.height = std::min(min_size.height, image.size().height);
-    }
-
-    if (resized_images.size() < source_images.size()) {
-      resized_images.resize(source_images.size());
-    }
-
-    for (size_t i = 0; i < source_images.size(); ++i) {
-      resized_images[i] = source_images[i](cv::Rect(0, 0, min_size.width, min_size.height)).clone();
-    }
-
     for (size_t i = 0; i < picture_boxes->Count; ++i) {
       if (!i) {
         picture_boxes[i]->Location = System::Drawing::Point(picture_box_panel_->Location.X + PICTURE_BOX_LOCATION_GAP, picture_box_panel_->Location.Y + PICTURE_BOX_LOCATION_GAP);
       } else {
-        picture_boxes[i]->Location = System::Drawing::Point(picture_boxes[i - 1]->Location.X + min_size.width + PICTURE_BOX_LOCATION_GAP, picture_boxes[i - 1]->Location.Y);
+        picture_boxes[i]->Location = System::Drawing::Point(picture_boxes[i - 1]->Location.X + image_store.Image(i - 1).cols + PICTURE_BOX_LOCATION_GAP, picture_boxes[i - 1]->Location.Y);
       }
     }
 
@@ -342,18 +195,18 @@ namespace ImageMorphing {
 
   void ApplicationForm::PaintPictureBoxWithFeatures() {
 
-    if (!resized_images.size()) {
+    if (!image_store.ImageCount()) {
       return;
     }
 
-    if (images_with_feature_lines.size() != resized_images.size()) {
-      images_with_feature_lines.resize(resized_images.size());
+    if (images_with_feature_lines.size() != image_store.ImageCount()) {
+      images_with_feature_lines.resize(image_store.ImageCount());
     }
 
     size_t max_feature_lines_count = 0;
 
     for (size_t i = 0; i < images_with_feature_lines.size(); ++i) {
-      images_with_feature_lines[i] = resized_images[i].clone();
+      images_with_feature_lines[i] = image_store.Image(i).clone();
       max_feature_lines_count = std::max(max_feature_lines_count, feature_lines_of_images[i].size());
     }
 
@@ -380,12 +233,13 @@ namespace ImageMorphing {
   System::Drawing::Bitmap ^ApplicationForm::CVMatToBitmap(const cv::Mat &mat) {
     //return gcnew System::Drawing::Bitmap(mat.cols, mat.rows, mat.step, System::Drawing::Imaging::PixelFormat::Format24bppRgb, (System::IntPtr)mat.data);
 
-    if (mat.type() != CV_8UC3) {
-      throw gcnew NotSupportedException("Only images of type CV_8UC3 are supported for conversion to Bitmap");
+    if (mat.type() != CV_8UC3 && mat.type() != CV_8UC4) {
+      throw gcnew NotSupportedException("Only images of type CV_8UC3 or CV_8UC4 are supported for conversion to Bitmap");
     }
 
-    // Create the bitmap and get the pointer to the bitmap
-    System::Drawing::Imaging::PixelFormat pixel_format(System::Drawing::Imaging::PixelFormat::Format24bppRgb);
+    // Create the bitmap and get the pointer to the bitmap. BGRA images carry premultiplied alpha, as PArgb bitmaps do.
+    System::Drawing::Imaging::PixelFormat pixel_format(mat.type() == CV_8UC4 ?
+      System::Drawing::Imaging::PixelFormat::Format32bppPArgb : System::Drawing::Imaging::PixelFormat::Format24bppRgb);
 
     System::Drawing::Bitmap ^bitmap = gcnew System::Drawing::Bitmap(mat.cols, mat.rows, pixel_format);
 
@@ -409,117 +263,222 @@ namespace ImageMorphing {
       feature_lines_of_images.resize(picture_boxes->Count);
     }
 
-    for (auto &feature_lines : feature_lines_of_images) {
-      feature_lines.clear();
+    std::vector<std::vector<FeatureLine> > loaded_feature_lines_of_images;
+    LoadFeatureLines(file_path, loaded_feature_lines_of_images);
+
+    for (size_t i = 0; i < feature_lines_of_images.size(); ++i) {
+      feature_lines_of_images[i] = i < loaded_feature_lines_of_images.size() ? loaded_feature_lines_of_images[i] : std::vector<FeatureLine>();
     }
 
-    std::ifstream features_input_stream(file_path);
+    PaintPictureBoxWithFeatures();
+  }
 
-    std::pair<cv::Point2d, cv::Point2d> feature_line;
+  void ApplicationForm::SaveFeatures(const std::string &file_path) {
+    SaveFeatureLines(file_path, feature_lines_of_images);
+  }
 
-    size_t target_index = 0;
+  namespace {
 
-    while (features_input_stream >> feature_line.first.x >> feature_line.first.y >> feature_line.second.x >> feature_line.second.y) {
-      if (feature_line.first.x < 0) {
-        ++target_index;
-        continue;
-      }
+    // Frame scaled down to fit the preview window
+    cv::Mat PreviewDisplayFrame(const cv::Mat &frame) {
+      const double scale = std::min(1.0, std::min(PREVIEW_DISPLAY_MAX_WIDTH / (double)frame.cols, PREVIEW_DISPLAY_MAX_HEIGHT / (double)frame.rows));
+      return ResampleImage(frame, cv::Size(std::max(1, (int)(frame.cols * scale)), std::max(1, (int)(frame.rows * scale))));
+    }
 
-      if (target_index >= feature_lines_of_images.size()) {
-        break;
-      }
+  }
+
+  void ApplicationForm::SaveResult(const std::string &file_path) {
+    feature_lines_of_images.resize(image_store.ImageCount());
 
-      feature_lines_of_images[target_index].push_back(feature_line);
+    ResultRender *result_render = new ResultRender(file_path);
+
+    // Every image is fitted once to the frame size of the first image's aspect ratio that all of them cover: nothing gets enlarged
+    // nor stretched, images of another aspect ratio lose a band on two sides
+    result_render->frame_size_ = image_store.CommonSize();
+
+    for (size_t i = 0; i < image_store.ImageCount(); ++i) {
+      result_render->images_.push_back(image_store.Resampled(i, result_render->frame_size_));
+      result_render->feature_lines_of_images_.push_back(FitFeatureLines(feature_lines_of_images[i], image_store.Image(i).size(), result_render->frame_size_));
     }
 
-    PaintPictureBoxWithFeatures();
+    PadFeatureLines(result_render->feature_lines_of_images_);
+
+    result_render->frame_count_ = System::Decimal::ToInt32(morphing_steps_numeric_up_down_->Value);
+
+    if (!result_render->frame_sink_.Open(result_render->frame_size_)) {
+      std::cerr << "Could not open " << file_path << ".\n";
+      delete result_render;
+      return;
+    }
+
+    result_render_ = result_render;
+
+    // Only the preview window takes input until the video is saved
+    this->Enabled = false;
+
+    ShowPreviewWindow(MorphSequenceFrames(result_render->images_.size(), result_render->frame_count_).size());
+
+    result_thread_ = gcnew System::Threading::Thread(gcnew System::Threading::ThreadStart(this, &ImageMorphing::ApplicationForm::RenderResult));
+    result_thread_->IsBackground = true;
+    result_thread_->Start();
   }
 
-  void ApplicationForm::SaveFeatures(const std::string &file_path) {
-    std::ofstream features_output_stream(file_path);
+  void ApplicationForm::RenderResult() {
+    ResultRender &result_render = *result_render_;
 
-    for (const auto &feature_lines : feature_lines_of_images) {
-      for (const auto &feature_line : feature_lines) {
-        features_output_stream << feature_line.first.x << " " << feature_line.first.y << " " << feature_line.second.x << " " << feature_line.second.y << "\n";
-      }
-      features_output_stream << "-1 -1 -1 -1\n";
+    gcroot<ApplicationForm ^> form(this);
+    gcroot<ResultFrameHandler ^> frame_handler = gcnew ResultFrameHandler(this, &ImageMorphing::ApplicationForm::OnResultFrameRendered);
+
+    // Frames only reach the UI thread as messages, scaled for display into a copy that OnResultFrameRendered takes over
+    auto post_frame = [&form, &frame_handler](const size_t frame_index, const cv::Mat &frame) {
+      cv::Mat *display_frame = new cv::Mat(PreviewDisplayFrame(frame));
+      form->BeginInvoke(static_cast<ResultFrameHandler ^>(frame_handler), (int)frame_index, System::IntPtr(display_frame));
+    };
+
+    const std::vector<FeatureLineSpan> feature_line_spans(result_render.feature_lines_of_images_.begin(), result_render.feature_lines_of_images_.end());
+
+    size_t preview_frame_index = 0;
+    size_t frame_index = 0;
+
+    try {
+      // The preview pass solves a mesh with 4^DEFAULT_PREVIEW_LEVEL times fewer vertices on images as much smaller,
+      // so the whole timing can be scrubbed long before the full frames are done. Full frames replace the preview ones as they come in.
+      result_render.sequence_renderer_.RenderProgressive(result_render.images_.size(), [&result_render](const size_t image_index) {
+        return result_render.images_[image_index];
+      }, feature_line_spans, result_render.frame_count_, result_render.frame_size_, DEFAULT_PREVIEW_LEVEL, [&](const cv::Mat &preview_frame) {
+        post_frame(preview_frame_index++, preview_frame);
+      }, [&](const cv::Mat &frame) {
+        result_render.frame_sink_.Write(frame);
+        post_frame(frame_index++, frame);
+      });
+    } catch (const std::exception &exception) {
+      std::cerr << "Could not save the video: " << exception.what() << "\n";
     }
+
+    form->BeginInvoke(gcnew System::Windows::Forms::MethodInvoker(this, &ImageMorphing::ApplicationForm::OnResultRendered));
   }
 
-  void ApplicationForm::SaveResult(const std::string &file_path) {
-    std::vector<std::pair<cv::Point2d, cv::Point2d> > &max_amount_features_lines = feature_lines_of_images[0];
+  void ApplicationForm::OnResultFrameRendered(int frame_index, System::IntPtr display_frame) {
+    cv::Mat *frame = static_cast<cv::Mat *>(display_frame.ToPointer());
 
-    for (const auto &features_lines : feature_lines_of_images) {
-      if (features_lines.size() > max_amount_features_lines.size()) {
-        max_amount_features_lines = features_lines;
-      }
+    // Picked up by the preview timer
+    if (frame_index < (int)preview_frames_->size()) {
+      (*preview_frames_)[frame_index] = *frame;
     }
 
-    for (auto &features_lines : feature_lines_of_images) {
-      for (size_t i = features_lines.size(); i < max_amount_features_lines.size(); ++i) {
-        features_lines.push_back(max_amount_features_lines[i]);
-      }
+    delete frame;
+  }
+
+  void ApplicationForm::OnResultRendered() {
+    // Posted last by the render thread, so no frame of this video is still on its way
+    result_thread_->Join();
+    result_thread_ = nullptr;
+
+    const bool is_canceled = result_render_->sequence_renderer_.IsCanceled();
+
+    result_render_->frame_sink_.Close();
+
+    delete result_render_;
+    result_render_ = nullptr;
+
+    preview_cancel_button_->Enabled = false;
+
+    this->Enabled = true;
+
+    // A canceled video keeps the frames encoded before the cancel
+    std::cout << (is_canceled ? "Canceled.\n" : "Done.\n");
+
+    if (is_closing_after_render_) {
+      Close();
     }
+  }
 
-    const double FPS = 30;
+  void ApplicationForm::OnPreviewCancelClick(System::Object ^sender, System::EventArgs ^e) {
+    if (result_render_) {
+      result_render_->sequence_renderer_.Cancel();
+      preview_cancel_button_->Enabled = false;
+    }
+  }
 
-    const size_t FRAME_COUNT = System::Decimal::ToInt32(morphing_steps_numeric_up_down_->Value);
+  void ApplicationForm::OnFormClosing(System::Object ^sender, System::Windows::Forms::FormClosingEventArgs ^e) {
+    // The render thread still uses the form and the renderer, so the form closes once OnResultRendered has run
+    if (result_render_) {
+      e->Cancel = true;
+      is_closing_after_render_ = true;
+      result_render_->sequence_renderer_.Cancel();
+    }
+  }
 
-    const size_t INTERPOLATION_FRAME_COUNT = 5;
-    const double INTERPOLATION_GAP = 1.0 / (double)INTERPOLATION_FRAME_COUNT;
+  void ApplicationForm::ShowPreviewWindow(const size_t frame_count) {
+    if (!preview_form_) {
+      preview_form_ = gcnew System::Windows::Forms::Form();
+      preview_form_->Text = L"Preview";
+      preview_form_->Owner = this;
+      preview_form_->ClientSize = System::Drawing::Size(PREVIEW_DISPLAY_MAX_WIDTH, PREVIEW_DISPLAY_MAX_HEIGHT + 68);
+      preview_form_->FormClosing += gcnew System::Windows::Forms::FormClosingEventHandler(this, &ImageMorphing::ApplicationForm::OnPreviewFormClosing);
 
-    cv::VideoWriter result_video_writer;
+      preview_picture_box_ = gcnew System::Windows::Forms::PictureBox();
+      preview_picture_box_->Dock = System::Windows::Forms::DockStyle::Fill;
+      preview_picture_box_->SizeMode = System::Windows::Forms::PictureBoxSizeMode::Zoom;
 
-    result_video_writer.open(file_path, CV_FOURCC('D', 'I', 'V', 'X'), FPS, resized_images[0].size());
+      preview_track_bar_ = gcnew System::Windows::Forms::TrackBar();
+      preview_track_bar_->Dock = System::Windows::Forms::DockStyle::Bottom;
+      preview_track_bar_->ValueChanged += gcnew System::EventHandler(this, &ImageMorphing::ApplicationForm::OnPreviewChanged);
 
-    size_t f = 0;
-    for (size_t image_index = 1; image_index < source_images.size(); ++image_index) {
+      preview_cancel_button_ = gcnew System::Windows::Forms::Button();
+      preview_cancel_button_->Dock = System::Windows::Forms::DockStyle::Bottom;
+      preview_cancel_button_->Text = L"Cancel";
+      preview_cancel_button_->Click += gcnew System::EventHandler(this, &ImageMorphing::ApplicationForm::OnPreviewCancelClick);
 
-      double t_gap = 1.0 / (double)FRAME_COUNT;
+      preview_form_->Controls->Add(preview_picture_box_);
+      preview_form_->Controls->Add(preview_track_bar_);
+      preview_form_->Controls->Add(preview_cancel_button_);
 
-      for (size_t frame_index = !(image_index == 1); frame_index <= FRAME_COUNT; ++frame_index) {
-        double t = t_gap * frame_index;
-        cv::Mat frame_at_t = Morphing(resized_images[image_index - 1], resized_images[image_index], t, feature_lines_of_images[image_index - 1], feature_lines_of_images[image_index], 1, 2, 0);
+      preview_timer_ = gcnew System::Windows::Forms::Timer();
+      preview_timer_->Interval = PREVIEW_REFRESH_INTERVAL;
+      preview_timer_->Tick += gcnew System::EventHandler(this, &ImageMorphing::ApplicationForm::OnPreviewChanged);
+    }
 
-        //frame_at_t = cv::Mat::zeros(frame_at_t.size(), frame_at_t.type());
+    preview_frames_->assign(frame_count, cv::Mat());
+    shown_preview_frame_data_ = nullptr;
 
-        // Draw feature lines in the result frame
+    preview_track_bar_->Value = 0;
+    preview_track_bar_->Maximum = std::max<int>(0, (int)frame_count - 1);
 
-        //for (size_t j = 0; j < feature_lines_of_images[image_index - 1].size(); ++j) {
-        //  const auto &feature_line = LineInterpolation(feature_lines_of_images[image_index][j], feature_lines_of_images[image_index - 1][j], 1 - t);
-        //  cv::arrowedLine(frame_at_t, feature_line.first, feature_line.second, feature_colors[j], FEATURE_LINE_THICKNESS);
-        //}
+    preview_cancel_button_->Enabled = true;
 
-        // Ouput each frame as an image
+    preview_timer_->Start();
+    preview_form_->Show();
+  }
 
-        //cv::imwrite(std::to_string(image_index) + "_" + std::to_string(f++) + ".jpg", frame_at_t);
-        result_video_writer.write(frame_at_t);
+  void ApplicationForm::ShowPreviewFrame() {
+    if (!preview_form_->Visible || preview_track_bar_->Value >= (int)preview_frames_->size()) {
+      return;
+    }
 
-        std::cout << "Done : " << image_index << " - " << t << "\n";
-      }
+    const cv::Mat &preview_frame = (*preview_frames_)[preview_track_bar_->Value];
 
-      //for (size_t i = 0; i < result_at_t.size(); ++i) {
-      //  if (!i) {
-      //    if (image_index == 1) {
-      //      result_video_writer.write(result_at_t[i]);
-      //    }
-      //  } else {
-      //    for (double delta_t = INTERPOLATION_GAP; delta_t <= 1; delta_t += INTERPOLATION_GAP) {
-      //      cv::Mat interpolated_image;
-      //      cv::addWeighted(result_at_t[i - 1], (1 - delta_t), result_at_t[i], delta_t, 0.0, interpolated_image);
-      //      result_video_writer.write(interpolated_image);
-      //    }
-      //  }
-      //}
+    // Only redraw when the frame under the track bar changed
+    if (preview_frame.empty() || preview_frame.data == shown_preview_frame_data_) {
+      return;
     }
 
-    //for (double t = 0; t <= 1; t += t_gap) {
-    //  cv::Mat result_at_t = Morphing(resized_source_image, resized_destination_image, t, source_feature_lines, destination_feature_lines, 1, 2, 0);
+    delete preview_picture_box_->Image;
+    preview_picture_box_->Image = CVMatToBitmap(preview_frame);
 
-    //  result_video_writer.write(result_at_t);
-    //}
+    shown_preview_frame_data_ = preview_frame.data;
+  }
 
-    std::cout << "Done.\n";
+  void ApplicationForm::OnPreviewChanged(System::Object ^sender, System::EventArgs ^e) {
+    ShowPreviewFrame();
+  }
+
+  void ApplicationForm::OnPreviewFormClosing(System::Object ^sender, System::Windows::Forms::FormClosingEventArgs ^e) {
+    // Kept for the next video, and a render may still be filling it
+    if (e->CloseReason == System::Windows::Forms::CloseReason::UserClosing) {
+      e->Cancel = true;
+      preview_form_->Hide();
+    }
   }
 
   void ApplicationForm::Test() {
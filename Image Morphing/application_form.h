@@ -9,46 +9,27 @@
 #include <fstream>
 #include <vector>
 
-#include <GL\glew.h>
 #include <omp.h>
 #include <opencv\cv.hpp>
 
-#include "morphing.h"
+#include "cpu_render_backend.h"
+#include "feature_io.h"
+#include "frame_sink.h"
+#include "image_resampling.h"
+#include "image_store.h"
+#include "morph_engine.h"
+#include "morph_sequence.h"
+#include "morph_sequence_renderer.h"
 
 #include <msclr\marshal_cppstd.h>
+#include <vcclr.h>
 #using <mscorlib.dll>
 
 namespace ImageMorphing {
 
-  static HWND hwnd;
-  static HDC hdc;
-  static HGLRC hrc;
-
-  const std::string DEFAULT_VERTEX_SHADER_FILE_PATH = "..\\shader\\vertex_shader.glsl";
-  const std::string DEFAULT_FRAGMENT_SHADER_FILE_PATH = "..\\shader\\fragment_shader.glsl";
-
-  const std::string SHADER_ATTRIBUTE_VERTEX_POSITION_NAME = "vertex_position";
-  const std::string SHADER_ATTRIBUTE_VERTEX_COLOR_NAME = "vertex_color";
-  const std::string SHADER_ATTRIBUTE_VERTEX_UV_NAME = "vertex_uv";
-
-  const std::string SHADER_UNIFORM_MODELVIEW_MATRIX_NAME = "modelview_matrix";
-  const std::string SHADER_UNIFORM_VIEW_MATRIX_NAME = "view_matrix";
-  const std::string SHADER_UNIFORM_PROJECTION_MATRIX_NAME = "projection_matrix";
-  const std::string SHADER_UNIFORM_TEXTURE_NAME = "texture";
-  const std::string SHADER_UNIFORM_TEXTURE_FLAG_NAME = "texture_flag";
-
-  GLint shader_program_id;
-  GLint shader_attribute_vertex_position_id;
-  GLint shader_attribute_vertex_color_id;
-  GLint shader_attribute_vertex_uv_id;
-  GLint shader_uniform_modelview_matrix_id;
-  GLint shader_uniform_view_matrix_id;
-  GLint shader_uniform_projection_matrix_id;
-  GLint shader_uniform_texture_id;
-  GLint shader_uniform_texture_flag_id;
-
-  std::vector<cv::Mat> source_images;
-  std::vector<cv::Mat> resized_images;
+  // Every added image, decoded once. Feature lines are drawn on the images at their own size,
+  // both are resampled to a common size only when morphing.
+  ImageStore image_store;
   std::vector<cv::Mat> images_with_feature_lines;
 
   std::vector<std::vector<std::pair<cv::Point2d, cv::Point2d> > > feature_lines_of_images;
@@ -62,10 +43,39 @@ namespace ImageMorphing {
   const size_t FEATURE_LINE_THICKNESS = 2;
   const size_t PICTURE_BOX_LOCATION_GAP = 50;
 
-  using namespace System::Runtime::InteropServices;
+  // Frames of the preview window are kept at most this large
+  const int PREVIEW_DISPLAY_MAX_WIDTH = 640;
+  const int PREVIEW_DISPLAY_MAX_HEIGHT = 480;
 
-  [DllImport("opengl32.dll")]
-  extern HDC wglSwapBuffers(HDC hdc);
+  // How often the preview window picks up frames rendered meanwhile, in milliseconds
+  const int PREVIEW_REFRESH_INTERVAL = 100;
+
+  const double RESULT_FPS = 30;
+
+  // A video saved in the background. Created on the UI thread, used by the render thread until it posts that it is done,
+  // then deleted on the UI thread.
+  struct ResultRender {
+
+    explicit ResultRender(const std::string &file_path) : sequence_renderer_([] {
+      return std::unique_ptr<RenderBackend>(new CPURenderBackend());
+    }), frame_sink_(file_path, DEFAULT_VIDEO_FOURCC, RESULT_FPS), frame_count_(0) {
+    }
+
+    // CPU backends, so frames are morphed on every core while the UI thread stays free
+    MorphSequenceRenderer sequence_renderer_;
+    VideoFrameSink frame_sink_;
+
+    // Every image fitted to frame_size_, with its lines moved along and padded to the same count
+    cv::Size frame_size_;
+    std::vector<cv::Mat> images_;
+    std::vector<std::vector<FeatureLine> > feature_lines_of_images_;
+
+    // Frames from one image to the next
+    size_t frame_count_;
+  };
+
+  // Hands a frame of the video, scaled for display and owned by the receiver, from the render thread to the UI thread
+  delegate void ResultFrameHandler(int frame_index, System::IntPtr display_frame);
 
   using namespace System;
   using namespace System::ComponentModel;
@@ -85,10 +95,6 @@ namespace ImageMorphing {
 
   private:
 
-    static bool ParseFileIntoString(const std::string &file_path, std::string &file_string);
-
-    void InitializeOpenGL();
-
     System::Collections::Generic::List<System::Windows::Forms::PictureBox ^> ^picture_boxes;
 
     void OnButtonsClick(System::Object ^sender, System::EventArgs ^e);
@@ -99,7 +105,7 @@ namespace ImageMorphing {
 
     void AddImage(System::String ^file_path);
 
-    void AdjustImagesSize();
+    void LayoutPictureBoxes();
 
     void PaintPictureBoxWithFeatures();
 
@@ -109,10 +115,50 @@ namespace ImageMorphing {
 
     void SaveFeatures(const std::string &file_path);
 
+    // Starts saving the video in the background, the form is disabled until it is done
     void SaveResult(const std::string &file_path);
 
+    // Body of result_thread_: previews every frame, then renders and encodes the full frames, posting all of them to the preview window
+    void RenderResult();
+
+    void OnResultFrameRendered(int frame_index, System::IntPtr display_frame);
+
+    void OnResultRendered();
+
+    void OnPreviewCancelClick(System::Object ^sender, System::EventArgs ^e);
+
+    void OnFormClosing(System::Object ^sender, System::Windows::Forms::FormClosingEventArgs ^e);
+
+    // Window scrubbing through the frames of the sequence being saved. Every frame shows up there first at low resolution,
+    // then at full resolution once it is morphed.
+    void ShowPreviewWindow(const size_t frame_count);
+
+    void ShowPreviewFrame();
+
+    void OnPreviewChanged(System::Object ^sender, System::EventArgs ^e);
+
+    void OnPreviewFormClosing(System::Object ^sender, System::Windows::Forms::FormClosingEventArgs ^e);
+
     void Test();
 
+    // Null unless a video is being saved
+    ResultRender *result_render_;
+    System::Threading::Thread ^result_thread_;
+
+    // The form closes once the canceled render is done
+    bool is_closing_after_render_;
+
+    System::Windows::Forms::Form ^preview_form_;
+    System::Windows::Forms::PictureBox ^preview_picture_box_;
+    System::Windows::Forms::TrackBar ^preview_track_bar_;
+    System::Windows::Forms::Timer ^preview_timer_;
+    System::Windows::Forms::Button ^preview_cancel_button_;
+
+    // One frame per frame of the sequence, empty until rendered
+    std::vector<cv::Mat> *preview_frames_;
+
+    const unsigned char *shown_preview_frame_data_;
+
   protected:
     /// <summary>
     /// Clean up any resources being used.
@@ -0,0 +1,225 @@
+#include "golden_check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "cpu_render_backend.h"
+#include "feature_io.h"
+#include "image_resampling.h"
+#include "morph_engine.h"
+
+namespace ImageMorphing {
+
+  namespace {
+
+    struct GoldenMorph {
+      const char *name_;
+      const char *source_image_name_;
+      const char *destination_image_name_;
+      const char *features_name_;
+      // The feature file lists the lines of the destination first
+      bool is_reversed_;
+    };
+
+    const GoldenMorph GOLDEN_MORPHS[] = {
+      { "butterfly", "butterfly.jpg", "butterfly2.jpg", "butterfly.txt", false },
+      { "tiger", "tiger.jpg", "woman.jpg", "tiger_woman.txt", false },
+      { "woman", "woman.jpg", "tiger.jpg", "tiger_woman.txt", true }
+    };
+
+    const double GOLDEN_TS[] = { 0, 0.25, 0.5, 0.75, 1 };
+
+    const std::string BASELINE_FILE_NAME = "baseline.txt";
+
+    // Frames are compared to an identical golden frame as this PSNR rather than infinity
+    const double IDENTICAL_PSNR = 1000;
+
+    std::string GoldenFramePath(const std::string &golden_directory, const std::string &morph_name, const size_t frame_index) {
+      return golden_directory + "/" + morph_name + "_" + std::to_string(frame_index) + ".png";
+    }
+
+    double PSNR(const cv::Mat &frame, const cv::Mat &golden_frame) {
+      const double mean_squared_error = cv::norm(frame, golden_frame, cv::NORM_L2SQR) / (double)(frame.total() * frame.channels());
+      return mean_squared_error > 0 ? 10 * std::log10(255 * 255 / mean_squared_error) : IDENTICAL_PSNR;
+    }
+
+    // One "<morph> <frames per second>" line per morph
+    std::map<std::string, double> LoadBaseline(const std::string &file_path) {
+      std::map<std::string, double> frames_per_second_of_morphs;
+
+      std::ifstream baseline_input_stream(file_path);
+
+      std::string morph_name;
+      double frames_per_second;
+
+      while (baseline_input_stream >> morph_name >> frames_per_second) {
+        frames_per_second_of_morphs[morph_name] = frames_per_second;
+      }
+
+      return frames_per_second_of_morphs;
+    }
+
+    bool SaveBaseline(const std::string &file_path, const std::map<std::string, double> &frames_per_second_of_morphs) {
+      std::ofstream baseline_output_stream(file_path);
+
+      for (const auto &frames_per_second : frames_per_second_of_morphs) {
+        baseline_output_stream << frames_per_second.first << " " << frames_per_second.second << "\n";
+      }
+
+      return (bool)baseline_output_stream;
+    }
+
+    // Both images fitted to CommonFrameSize of the two, with their lines moved along
+    bool LoadGoldenMorph(const std::string &data_directory, const GoldenMorph &golden_morph,
+      cv::Mat &source_image, cv::Mat &destination_image,
+      std::vector<FeatureLine> &source_feature_lines, std::vector<FeatureLine> &destination_feature_lines) {
+      source_image = cv::imread(data_directory + "/" + golden_morph.source_image_name_, cv::IMREAD_COLOR);
+      destination_image = cv::imread(data_directory + "/" + golden_morph.destination_image_name_, cv::IMREAD_COLOR);
+
+      std::vector<std::vector<FeatureLine> > feature_lines_of_images;
+
+      if (source_image.empty() || destination_image.empty() ||
+        !LoadFeatureLines(data_directory + "/" + golden_morph.features_name_, feature_lines_of_images) || feature_lines_of_images.size() != 2 ||
+        feature_lines_of_images[0].size() != feature_lines_of_images[1].size()) {
+        std::cerr << "Could not load the images and feature lines of " << golden_morph.name_ << " from " << data_directory << ".\n";
+        return false;
+      }
+
+      if (golden_morph.is_reversed_) {
+        std::swap(feature_lines_of_images[0], feature_lines_of_images[1]);
+      }
+
+      std::vector<cv::Size> image_sizes;
+      image_sizes.push_back(source_image.size());
+      image_sizes.push_back(destination_image.size());
+
+      const cv::Size common_size = CommonFrameSize(image_sizes);
+
+      source_feature_lines = FitFeatureLines(feature_lines_of_images[0], source_image.size(), common_size);
+      destination_feature_lines = FitFeatureLines(feature_lines_of_images[1], destination_image.size(), common_size);
+
+      source_image = FitImage(source_image, common_size);
+      destination_image = FitImage(destination_image, common_size);
+
+      return true;
+    }
+
+  }
+
+  bool RunGoldenCheck(const GoldenCheckOptions &options) {
+    const std::string baseline_path = options.golden_directory_ + "/" + BASELINE_FILE_NAME;
+
+    std::map<std::string, double> frames_per_second_of_morphs = options.is_recording_ ? std::map<std::string, double>() : LoadBaseline(baseline_path);
+
+    const std::vector<double> ts(std::begin(GOLDEN_TS), std::end(GOLDEN_TS));
+
+    bool is_passing = true;
+
+    // Checks without recorded data are skipped, they cannot tell a regression
+    size_t unrecorded_frame_count = 0;
+    size_t unrecorded_baseline_count = 0;
+
+    for (const GoldenMorph &golden_morph : GOLDEN_MORPHS) {
+      cv::Mat source_image;
+      cv::Mat destination_image;
+      std::vector<FeatureLine> source_feature_lines;
+      std::vector<FeatureLine> destination_feature_lines;
+
+      if (!LoadGoldenMorph(options.data_directory_, golden_morph, source_image, destination_image, source_feature_lines, destination_feature_lines)) {
+        is_passing = false;
+        continue;
+      }
+
+      // A single solver thread, so the solution does not depend on how CPLEX splits the work
+      MorphEngine morph_engine(std::unique_ptr<RenderBackend>(new CPURenderBackend()));
+      morph_engine.options_.solver_thread_count_ = 1;
+
+      std::vector<cv::Mat> frames;
+      double best_seconds = 0;
+
+      for (size_t repetition = 0; repetition < std::max<size_t>(1, options.repetitions_); ++repetition) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        frames = morph_engine.MorphingBatch(source_image, destination_image, ts, source_feature_lines, destination_feature_lines);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        best_seconds = repetition ? std::min(best_seconds, seconds) : seconds;
+      }
+
+      const double frames_per_second = best_seconds > 0 ? frames.size() / best_seconds : 0;
+
+      if (options.is_recording_) {
+        for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index) {
+          if (!cv::imwrite(GoldenFramePath(options.golden_directory_, golden_morph.name_, frame_index), frames[frame_index])) {
+            std::cerr << "Could not write golden frame " << GoldenFramePath(options.golden_directory_, golden_morph.name_, frame_index) << ".\n";
+            is_passing = false;
+          }
+        }
+
+        frames_per_second_of_morphs[golden_morph.name_] = frames_per_second;
+        std::cerr << golden_morph.name_ << ": recorded " << frames.size() << " frames, " << frames_per_second << " fps\n";
+        continue;
+      }
+
+      for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index) {
+        const std::string golden_frame_path = GoldenFramePath(options.golden_directory_, golden_morph.name_, frame_index);
+        const cv::Mat golden_frame = cv::imread(golden_frame_path, cv::IMREAD_COLOR);
+
+        if (golden_frame.empty()) {
+          std::cerr << golden_morph.name_ << " frame " << frame_index << ": not recorded, no golden frame at " << golden_frame_path << "\n";
+          ++unrecorded_frame_count;
+          continue;
+        }
+
+        if (golden_frame.size() != frames[frame_index].size()) {
+          std::cerr << golden_morph.name_ << " frame " << frame_index << ": no golden frame of the same size at " << golden_frame_path << "\n";
+          is_passing = false;
+          continue;
+        }
+
+        const double psnr = PSNR(frames[frame_index], golden_frame);
+        const double max_error = cv::norm(frames[frame_index], golden_frame, cv::NORM_INF);
+
+        const bool is_matching = psnr >= options.min_psnr_ && max_error <= options.max_error_;
+        is_passing = is_passing && is_matching;
+
+        std::cerr << golden_morph.name_ << " frame " << frame_index << ": PSNR " << psnr << " dB, max error " << max_error << (is_matching ? "" : "  FAILED") << "\n";
+      }
+
+      const auto baseline = frames_per_second_of_morphs.find(golden_morph.name_);
+
+      if (baseline == frames_per_second_of_morphs.end()) {
+        std::cerr << golden_morph.name_ << ": " << frames_per_second << " fps, not recorded, no baseline in " << baseline_path << "\n";
+        ++unrecorded_baseline_count;
+        continue;
+      }
+
+      const double min_frames_per_second = baseline->second * (1 - options.fps_margin_);
+      const bool is_fast_enough = frames_per_second >= min_frames_per_second;
+      is_passing = is_passing && is_fast_enough;
+
+      std::cerr << golden_morph.name_ << ": " << frames_per_second << " fps, baseline " << baseline->second << " fps" << (is_fast_enough ? "" : "  FAILED") << "\n";
+    }
+
+    if (unrecorded_frame_count || unrecorded_baseline_count) {
+      std::cerr << unrecorded_frame_count << " golden frames and " << unrecorded_baseline_count << " baselines are not recorded and were skipped, "
+        "record them with --record-golden on the reference machine.\n";
+    }
+
+    if (options.is_recording_ && !SaveBaseline(baseline_path, frames_per_second_of_morphs)) {
+      std::cerr << "Could not write the baseline to " << baseline_path << ".\n";
+      return false;
+    }
+
+    return is_passing;
+  }
+
+}
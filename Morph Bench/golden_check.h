@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+
+namespace ImageMorphing {
+
+  // Frames matching their golden frame must have at least this PSNR, in dB
+  const double DEFAULT_GOLDEN_MIN_PSNR = 40;
+
+  // Largest difference of any channel of any pixel to its golden frame
+  const double DEFAULT_GOLDEN_MAX_ERROR = 16;
+
+  // A morph fails when its frames per second drop below its baseline by more than this fraction
+  const double DEFAULT_GOLDEN_FPS_MARGIN = 0.1;
+
+  struct GoldenCheckOptions {
+
+    GoldenCheckOptions() : is_recording_(false), min_psnr_(DEFAULT_GOLDEN_MIN_PSNR), max_error_(DEFAULT_GOLDEN_MAX_ERROR), fps_margin_(DEFAULT_GOLDEN_FPS_MARGIN), repetitions_(1) {
+    }
+
+    // Bundled images and their feature files
+    std::string data_directory_;
+
+    // Golden frames (<morph>_<frame>.png) and the frames per second of every morph (baseline.txt)
+    std::string golden_directory_;
+
+    // Writes the golden frames and the baseline instead of checking against them
+    bool is_recording_;
+
+    double min_psnr_;
+    double max_error_;
+    double fps_margin_;
+
+    // Times every morph is rendered when measuring its frames per second, the fastest one counts
+    size_t repetitions_;
+  };
+
+  // Renders fixed morphs of the bundled images with the CPU backend and compares them to the golden frames.
+  // Returns false when a frame differs too much or has another size, a morph got too slow, or an input is missing.
+  // Golden frames and baselines not recorded yet are reported and skipped, so a fresh checkout passes until they are recorded.
+  bool RunGoldenCheck(const GoldenCheckOptions &options);
+
+}
@@ -0,0 +1,709 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <omp.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "cpu_render_backend.h"
+#include "feature_line.h"
+#include "golden_check.h"
+#include "grid_mesh.h"
+#include "grid_mesh_solver.h"
+#include "image_resampling.h"
+#include "morph_engine.h"
+#include "morph_sequence_renderer.h"
+#include "morphing.h"
+#include "pixel_format.h"
+#include "pixel_kernels.h"
+#include "warping.h"
+
+namespace ImageMorphing {
+
+  enum ExitCode {
+    EXIT_CODE_SUCCESS = 0,
+    EXIT_CODE_USAGE = 1,
+    EXIT_CODE_OUTPUT = 3,
+    // A frame differs from its golden frame or a morph got slower than its baseline
+    EXIT_CODE_REGRESSION = 4
+  };
+
+  const std::string DEFAULT_DATA_DIRECTORY = "../data";
+
+  // Images of the data directory used as sources, the first two found are morphed into each other
+  const char *const DATA_IMAGE_NAMES[] = { "butterfly.jpg", "butterfly2.jpg", "tiger.jpg", "woman.jpg" };
+
+  const size_t DEFAULT_REPETITIONS = 5;
+
+  // Field warping costs pixels * lines, combinations above this are skipped rather than run for minutes
+  const double DEFAULT_MAX_FIELD_WARPING_WORK = 1 << 30;
+
+  // Destination lines move by at most this fraction of the image size from their source line
+  const double SYNTHETIC_LINE_JITTER = 0.05;
+
+  const unsigned int SYNTHETIC_LINE_SEED = 5489;
+
+  const size_t BILINEAR_SAMPLE_COUNT = 1 << 22;
+
+  const size_t LINE_INTERPOLATION_STEPS = 1000;
+
+  // Sub-frames of the motion blurred morph, over the shutter of a 30 frame transition
+  const size_t MOTION_BLUR_SUB_FRAME_COUNT = 8;
+  const double MOTION_BLUR_SHUTTER_T = DEFAULT_MOTION_BLUR_SHUTTER / 30;
+
+  // Batch of the pair morph: the two images into each other and back, each at a few values of t
+  const size_t MORPH_PAIR_COUNT = 4;
+  const double MORPH_PAIR_TS[] = { 0.25, 0.5, 0.75 };
+
+  struct BenchmarkOptions {
+
+    BenchmarkOptions() : data_directory_(DEFAULT_DATA_DIRECTORY), repetitions_(DEFAULT_REPETITIONS), max_field_warping_work_(DEFAULT_MAX_FIELD_WARPING_WORK) {
+      const int sizes[][2] = { { 256, 256 }, { 512, 512 }, { 1024, 1024 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+      for (const auto &size : sizes) {
+        image_sizes_.push_back(cv::Size(size[0], size[1]));
+      }
+
+      const size_t line_counts[] = { 1, 10, 50, 100, 500 };
+      line_counts_.assign(std::begin(line_counts), std::end(line_counts));
+
+      const size_t grid_sizes[] = { 10, 20, 40 };
+      grid_sizes_.assign(std::begin(grid_sizes), std::end(grid_sizes));
+
+      image_types_.push_back(CV_8UC3);
+
+      // Powers of two up to every hardware thread
+      const size_t hardware_thread_count = std::max<unsigned int>(1, std::thread::hardware_concurrency());
+      for (size_t thread_count = 1; thread_count < hardware_thread_count; thread_count *= 2) {
+        thread_counts_.push_back(thread_count);
+      }
+      thread_counts_.push_back(hardware_thread_count);
+    }
+
+    std::string data_directory_;
+
+    // Results go to stdout when empty
+    std::string output_path_;
+
+    // Only benchmarks whose name contains it run
+    std::string filter_;
+
+    size_t repetitions_;
+    double max_field_warping_work_;
+
+    std::vector<cv::Size> image_sizes_;
+    std::vector<size_t> line_counts_;
+    std::vector<size_t> grid_sizes_;
+    std::vector<size_t> thread_counts_;
+    std::vector<int> image_types_;
+
+    // Checks the golden frames instead of running the benchmarks when golden_check_.golden_directory_ is set
+    GoldenCheckOptions golden_check_;
+  };
+
+  void PrintUsage() {
+    std::cerr <<
+      "Usage: morph_bench [--data <dir>] [--output <file>] [--filter <name>] [--repetitions <count>]\n"
+      "                   [--sizes <w>x<h>,...] [--lines <count>,...] [--grid-sizes <pixels>,...] [--threads <count>,...]\n"
+      "                   [--pixel-types <type>,...] [--max-field-warping-work <pixels x lines>]\n"
+      "       morph_bench --verify-golden <dir> | --record-golden <dir> [--data <dir>] [--repetitions <count>]\n"
+      "                   [--min-psnr <dB>] [--max-error <value>] [--fps-margin <fraction>]\n"
+      "\n"
+      "  Times the kernels of the engine over every combination of the parameters they depend on and writes\n"
+      "  one JSON object per line and combination, with the minimum, median and mean time of the repetitions\n"
+      "  and the throughput of the fastest one.\n"
+      "\n"
+      "  --data       Directory of the bundled images (default " << DEFAULT_DATA_DIRECTORY << "). Synthetic images are used\n"
+      "               when none of them can be read.\n"
+      "  --output     File receiving the results (default stdout).\n"
+      "  --filter     Only run the benchmarks whose name contains it: bilinear_sample, line_interpolation,\n"
+      "               field_warping, vertex_targets, mesh_solve, cpu_render, cross_dissolve,\n"
+      "               cross_dissolve_linear_light (8-bit types only), morph, morph_motion_blur, morph_pairs.\n"
+      "  --repetitions\n"
+      "               Timed runs of every combination, after one untimed run (default " << DEFAULT_REPETITIONS << ").\n"
+      "  --sizes      Image sizes (default 256x256 to 7680x4320).\n"
+      "  --lines      Feature line counts (default 1,10,50,100,500).\n"
+      "  --grid-sizes Sizes of a cell of the warped mesh (default 10,20,40).\n"
+      "  --threads    Thread counts (default powers of two up to every core).\n"
+      "  --pixel-types\n"
+      "               Pixel types of the images: bgr8, bgra8, bgr16, bgr32f (default bgr8). Kernels that do not\n"
+      "               touch pixels run for the first one only.\n"
+      "  --max-field-warping-work\n"
+      "               Field warping combinations above this many pixels x lines are skipped (default 2^30).\n"
+      "\n"
+      "  Golden check: fixed morphs of the bundled images and their feature files are rendered on the CPU and compared\n"
+      "  to the golden frames of <dir>. Exits with " << EXIT_CODE_REGRESSION << " when a frame differs too much or a morph runs slower\n"
+      "  than its recorded baseline. Frames and baselines not recorded yet are reported as such and skipped.\n"
+      "  --verify-golden\n"
+      "               Directory of the golden frames and baseline.txt to check against.\n"
+      "  --record-golden\n"
+      "               Directory receiving new golden frames and baseline.txt, on the reference machine.\n"
+      "  --min-psnr   Lowest PSNR of a frame to its golden frame (default " << DEFAULT_GOLDEN_MIN_PSNR << " dB).\n"
+      "  --max-error  Largest difference of a channel to its golden frame (default " << DEFAULT_GOLDEN_MAX_ERROR << ").\n"
+      "  --fps-margin Fraction of its baseline frames per second a morph may lose (default " << DEFAULT_GOLDEN_FPS_MARGIN << ").\n";
+  }
+
+  template <typename T, typename Parse>
+  bool ParseList(const std::string &value, std::vector<T> &list, Parse parse) {
+    list.clear();
+
+    std::stringstream stream(value);
+    std::string item;
+
+    while (std::getline(stream, item, ',')) {
+      T parsed;
+      if (!parse(item, parsed)) {
+        return false;
+      }
+      list.push_back(parsed);
+    }
+
+    return !list.empty();
+  }
+
+  bool ParseCount(const std::string &item, size_t &count) {
+    count = std::strtoul(item.c_str(), nullptr, 10);
+    return count > 0;
+  }
+
+  bool ParseSize(const std::string &item, cv::Size &size) {
+    return std::sscanf(item.c_str(), "%dx%d", &size.width, &size.height) == 2 && size.width > 1 && size.height > 1;
+  }
+
+  bool ParseCommandLine(int argc, char **argv, BenchmarkOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string argument = argv[i];
+
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for " << argument << ".\n";
+        return false;
+      }
+
+      const std::string value = argv[++i];
+      bool is_valid = true;
+
+      if (argument == "--data") {
+        options.data_directory_ = value;
+      } else if (argument == "--output") {
+        options.output_path_ = value;
+      } else if (argument == "--filter") {
+        options.filter_ = value;
+      } else if (argument == "--repetitions") {
+        is_valid = ParseCount(value, options.repetitions_);
+      } else if (argument == "--sizes") {
+        is_valid = ParseList(value, options.image_sizes_, ParseSize);
+      } else if (argument == "--lines") {
+        is_valid = ParseList(value, options.line_counts_, ParseCount);
+      } else if (argument == "--grid-sizes") {
+        is_valid = ParseList(value, options.grid_sizes_, ParseCount);
+      } else if (argument == "--threads") {
+        is_valid = ParseList(value, options.thread_counts_, ParseCount);
+      } else if (argument == "--pixel-types") {
+        is_valid = ParseList(value, options.image_types_, ParseImageType);
+      } else if (argument == "--max-field-warping-work") {
+        options.max_field_warping_work_ = std::atof(value.c_str());
+      } else if (argument == "--verify-golden" || argument == "--record-golden") {
+        options.golden_check_.golden_directory_ = value;
+        options.golden_check_.is_recording_ = argument == "--record-golden";
+      } else if (argument == "--min-psnr") {
+        options.golden_check_.min_psnr_ = std::atof(value.c_str());
+      } else if (argument == "--max-error") {
+        options.golden_check_.max_error_ = std::atof(value.c_str());
+      } else if (argument == "--fps-margin") {
+        options.golden_check_.fps_margin_ = std::atof(value.c_str());
+      } else {
+        std::cerr << "Unknown option " << argument << ".\n";
+        return false;
+      }
+
+      if (!is_valid) {
+        std::cerr << "Invalid value " << value << " for " << argument << ".\n";
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Parameters of one measured combination, 0 when the benchmark does not depend on them
+  struct BenchmarkCase {
+
+    BenchmarkCase(const std::string &name, const cv::Size &image_size) : name_(name), image_size_(image_size), line_count_(0), grid_size_(0), thread_count_(0), item_count_(0) {
+    }
+
+    std::string name_;
+    cv::Size image_size_;
+
+    // Empty for kernels that do not touch pixels
+    std::string pixel_type_;
+
+    size_t line_count_;
+    size_t grid_size_;
+    size_t thread_count_;
+
+    // Work done by one repetition, in item_name_ (pixels, samples, ...)
+    double item_count_;
+    std::string item_name_;
+  };
+
+  class BenchmarkRunner {
+
+  public:
+
+    BenchmarkRunner(const BenchmarkOptions &options, std::ostream &output) : options_(options), output_(output) {
+    }
+
+    bool IsSelected(const std::string &name) const {
+      return name.find(options_.filter_) != std::string::npos;
+    }
+
+    // Runs function once untimed, then repetitions_ times, and writes the result of the case
+    void Measure(const BenchmarkCase &benchmark_case, const std::function<void()> &function) {
+      function();
+
+      std::vector<double> milliseconds;
+
+      for (size_t i = 0; i < options_.repetitions_; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        milliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+      }
+
+      std::sort(milliseconds.begin(), milliseconds.end());
+
+      double mean_milliseconds = 0;
+      for (const double m : milliseconds) {
+        mean_milliseconds += m / milliseconds.size();
+      }
+
+      const double min_milliseconds = milliseconds.front();
+
+      output_ << "{\"benchmark\": \"" << benchmark_case.name_ << "\""
+        << ", \"width\": " << benchmark_case.image_size_.width << ", \"height\": " << benchmark_case.image_size_.height
+        << ", \"pixel_type\": \"" << benchmark_case.pixel_type_ << "\""
+        << ", \"lines\": " << benchmark_case.line_count_ << ", \"grid_size\": " << benchmark_case.grid_size_ << ", \"threads\": " << benchmark_case.thread_count_
+        << ", \"repetitions\": " << milliseconds.size()
+        << ", \"min_ms\": " << min_milliseconds << ", \"median_ms\": " << milliseconds[milliseconds.size() / 2] << ", \"mean_ms\": " << mean_milliseconds
+        << ", \"item\": \"" << benchmark_case.item_name_ << "\", \"items_per_second\": " << (min_milliseconds > 0 ? benchmark_case.item_count_ * 1000 / min_milliseconds : 0)
+        << "}\n";
+      output_.flush();
+
+      std::cerr << benchmark_case.name_ << " " << benchmark_case.image_size_.width << "x" << benchmark_case.image_size_.height << " " << benchmark_case.pixel_type_
+        << " lines " << benchmark_case.line_count_ << " grid " << benchmark_case.grid_size_ << " threads " << benchmark_case.thread_count_
+        << ": " << min_milliseconds << " ms\n";
+    }
+
+  private:
+
+    const BenchmarkOptions &options_;
+    std::ostream &output_;
+  };
+
+  // Two different images, from the data directory when possible
+  void LoadSourceImages(const std::string &data_directory, cv::Mat &source_image, cv::Mat &destination_image) {
+    std::vector<cv::Mat> images;
+
+    for (const char *image_name : DATA_IMAGE_NAMES) {
+      cv::Mat image = cv::imread(data_directory + "/" + image_name, cv::IMREAD_COLOR);
+      if (!image.empty()) {
+        images.push_back(image);
+      }
+    }
+
+    if (images.size() < 2) {
+      std::cerr << "Could not read two images from " << data_directory << ", using synthetic images.\n";
+
+      cv::Mat synthetic_image(512, 512, CV_8UC3);
+      cv::randu(synthetic_image, cv::Scalar::all(0), cv::Scalar::all(256));
+      images.push_back(synthetic_image);
+      images.push_back(255 - synthetic_image);
+    }
+
+    source_image = images[0];
+    destination_image = images[1];
+  }
+
+  // Sum of the first channel of bilinear samples at positions, so the samples cannot be optimized away
+  template <typename T, int channel_count>
+  double BilinearSampleSum(const cv::Mat &image, const std::vector<cv::Point2d> &positions) {
+    T pixel[channel_count];
+    double sum = 0;
+
+    for (const auto &position : positions) {
+      BilinearSampleTo<T, channel_count>(image, position, pixel);
+      sum += pixel[0];
+    }
+
+    return sum;
+  }
+
+  double BilinearSampleSum(const cv::Mat &image, const std::vector<cv::Point2d> &positions) {
+    switch (image.type()) {
+    case CV_8UC3:
+      return BilinearSampleSum<uchar, 3>(image, positions);
+    case CV_8UC4:
+      return BilinearSampleSum<uchar, 4>(image, positions);
+    case CV_16UC3:
+      return BilinearSampleSum<ushort, 3>(image, positions);
+    case CV_32FC3:
+      return BilinearSampleSum<float, 3>(image, positions);
+    default:
+      return 0;
+    }
+  }
+
+  // Lines at random positions of an image of image_size, and the same lines slightly moved
+  void SyntheticFeatureLines(const cv::Size &image_size, const size_t line_count,
+    std::vector<FeatureLine> &source_feature_lines, std::vector<FeatureLine> &destination_feature_lines) {
+    std::mt19937 random(SYNTHETIC_LINE_SEED);
+    std::uniform_real_distribution<double> x(0, image_size.width - 1);
+    std::uniform_real_distribution<double> y(0, image_size.height - 1);
+    std::uniform_real_distribution<double> jitter(-SYNTHETIC_LINE_JITTER, SYNTHETIC_LINE_JITTER);
+
+    auto moved = [&](const cv::Point2d &point) {
+      return cv::Point2d(std::min(std::max(point.x + jitter(random) * image_size.width, 0.0), image_size.width - 1.0),
+        std::min(std::max(point.y + jitter(random) * image_size.height, 0.0), image_size.height - 1.0));
+    };
+
+    source_feature_lines.clear();
+    destination_feature_lines.clear();
+
+    while (source_feature_lines.size() < line_count) {
+      FeatureLine source_feature_line(cv::Point2d(x(random), y(random)), cv::Point2d(x(random), y(random)));
+      FeatureLine destination_feature_line(moved(source_feature_line.first), moved(source_feature_line.second));
+
+      // Degenerate lines have no direction
+      if (LineLength(source_feature_line) < 1 || LineLength(destination_feature_line) < 1) {
+        continue;
+      }
+
+      source_feature_lines.push_back(source_feature_line);
+      destination_feature_lines.push_back(destination_feature_line);
+    }
+  }
+
+  int Run(int argc, char **argv) {
+    BenchmarkOptions options;
+
+    if (!ParseCommandLine(argc, argv, options)) {
+      PrintUsage();
+      return EXIT_CODE_USAGE;
+    }
+
+    if (!options.golden_check_.golden_directory_.empty()) {
+      options.golden_check_.data_directory_ = options.data_directory_;
+      options.golden_check_.repetitions_ = options.repetitions_;
+
+      return RunGoldenCheck(options.golden_check_) ? EXIT_CODE_SUCCESS : EXIT_CODE_REGRESSION;
+    }
+
+    std::ofstream output_file;
+
+    if (!options.output_path_.empty()) {
+      output_file.open(options.output_path_);
+
+      if (!output_file) {
+        std::cerr << "Could not open output " << options.output_path_ << ".\n";
+        return EXIT_CODE_OUTPUT;
+      }
+    }
+
+    BenchmarkRunner runner(options, options.output_path_.empty() ? std::cout : output_file);
+
+    cv::Mat loaded_source_image;
+    cv::Mat loaded_destination_image;
+    LoadSourceImages(options.data_directory_, loaded_source_image, loaded_destination_image);
+
+    const size_t max_line_count = *std::max_element(options.line_counts_.begin(), options.line_counts_.end());
+
+    for (size_t type_index = 0; type_index < options.image_types_.size(); ++type_index) {
+      const int image_type = options.image_types_[type_index];
+      const std::string pixel_type = ImageTypeName(image_type);
+
+      // Kernels that do not touch pixels are the same for every pixel type
+      const bool is_first_type = !type_index;
+
+      for (const cv::Size &image_size : options.image_sizes_) {
+        const cv::Mat source_image = ConvertImageType(ResampleImage(loaded_source_image, image_size), image_type);
+        const cv::Mat destination_image = ConvertImageType(ResampleImage(loaded_destination_image, image_size), image_type);
+
+        const double pixel_count = image_size.area();
+
+        if (runner.IsSelected("bilinear_sample")) {
+          // Positions are drawn up front, so only the sampling is timed
+          std::mt19937 random(SYNTHETIC_LINE_SEED);
+          std::uniform_real_distribution<double> x(0, image_size.width - 1);
+          std::uniform_real_distribution<double> y(0, image_size.height - 1);
+
+          std::vector<cv::Point2d> positions(BILINEAR_SAMPLE_COUNT);
+          for (auto &position : positions) {
+            position = cv::Point2d(x(random), y(random));
+          }
+
+          BenchmarkCase benchmark_case("bilinear_sample", image_size);
+          benchmark_case.pixel_type_ = pixel_type;
+          benchmark_case.thread_count_ = 1;
+          benchmark_case.item_count_ = (double)positions.size();
+          benchmark_case.item_name_ = "samples";
+
+          double sum = 0;
+
+          runner.Measure(benchmark_case, [&] {
+            sum = BilinearSampleSum(source_image, positions);
+          });
+
+          // Keeps the samples from being optimized away
+          if (sum < 0) {
+            std::cerr << sum;
+          }
+        }
+
+        for (const size_t line_count : options.line_counts_) {
+          std::vector<FeatureLine> source_feature_lines;
+          std::vector<FeatureLine> destination_feature_lines;
+          SyntheticFeatureLines(image_size, line_count, source_feature_lines, destination_feature_lines);
+
+          // Independent of the image size, measured once
+          if (runner.IsSelected("line_interpolation") && image_size == options.image_sizes_.front() && is_first_type) {
+            BenchmarkCase benchmark_case("line_interpolation", cv::Size());
+            benchmark_case.line_count_ = line_count;
+            benchmark_case.thread_count_ = 1;
+            benchmark_case.item_count_ = (double)line_count * LINE_INTERPOLATION_STEPS;
+            benchmark_case.item_name_ = "lines";
+
+            double length_sum = 0;
+
+            runner.Measure(benchmark_case, [&] {
+              for (size_t step = 0; step < LINE_INTERPOLATION_STEPS; ++step) {
+                const double t = step / (double)LINE_INTERPOLATION_STEPS;
+                for (size_t i = 0; i < line_count; ++i) {
+                  length_sum += SqrLineLength(LineInterpolation(source_feature_lines[i], destination_feature_lines[i], t));
+                }
+              }
+            });
+
+            if (length_sum < 0) {
+              std::cerr << length_sum;
+            }
+          }
+
+          if (runner.IsSelected("field_warping") && pixel_count * line_count <= options.max_field_warping_work_) {
+            for (const size_t thread_count : options.thread_counts_) {
+              omp_set_num_threads((int)thread_count);
+
+              BenchmarkCase benchmark_case("field_warping", image_size);
+              benchmark_case.pixel_type_ = pixel_type;
+              benchmark_case.line_count_ = line_count;
+              benchmark_case.thread_count_ = thread_count;
+              benchmark_case.item_count_ = pixel_count;
+              benchmark_case.item_name_ = "pixels";
+
+              runner.Measure(benchmark_case, [&] {
+                ImageWarping(source_image, source_feature_lines, destination_feature_lines, 1, 2, 0);
+              });
+            }
+          }
+
+          if (runner.IsSelected("vertex_targets") && is_first_type) {
+            for (const size_t grid_size : options.grid_sizes_) {
+              const GridMesh grid_mesh(image_size, grid_size);
+
+              BenchmarkCase benchmark_case("vertex_targets", image_size);
+              benchmark_case.line_count_ = line_count;
+              benchmark_case.grid_size_ = grid_size;
+              benchmark_case.thread_count_ = 1;
+              benchmark_case.item_count_ = (double)grid_mesh.graph_.vertices_.size();
+              benchmark_case.item_name_ = "vertices";
+
+              runner.Measure(benchmark_case, [&] {
+                ComputeWarpedGridTargets(grid_mesh, source_feature_lines, destination_feature_lines, 1, 2, 0);
+              });
+            }
+          }
+        }
+
+        // The kernels below only depend on the lines through the warped mesh, so they run with the most lines
+        std::vector<FeatureLine> source_feature_lines;
+        std::vector<FeatureLine> destination_feature_lines;
+        SyntheticFeatureLines(image_size, max_line_count, source_feature_lines, destination_feature_lines);
+
+        const bool is_mesh_benchmark_selected = (runner.IsSelected("mesh_solve") && is_first_type) || runner.IsSelected("cpu_render") ||
+          runner.IsSelected("morph") || runner.IsSelected("morph_motion_blur") || runner.IsSelected("morph_pairs");
+
+        for (size_t grid_index = 0; grid_index < options.grid_sizes_.size() && is_mesh_benchmark_selected; ++grid_index) {
+          const size_t grid_size = options.grid_sizes_[grid_index];
+          const GridMesh grid_mesh(image_size, grid_size);
+          const std::vector<glm::vec2> target_vertices = ComputeWarpedGridTargets(grid_mesh, source_feature_lines, destination_feature_lines, 1, 2, 0);
+
+          GridMeshSolver grid_mesh_solver;
+          grid_mesh_solver.SetGridMesh(grid_mesh);
+
+          std::vector<glm::vec2> warped_vertices;
+          grid_mesh_solver.Solve(target_vertices, warped_vertices);
+
+          for (const size_t thread_count : options.thread_counts_) {
+            omp_set_num_threads((int)thread_count);
+
+            if (runner.IsSelected("mesh_solve") && is_first_type) {
+              grid_mesh_solver.SetThreadCount(thread_count);
+
+              BenchmarkCase benchmark_case("mesh_solve", image_size);
+              benchmark_case.grid_size_ = grid_size;
+              benchmark_case.thread_count_ = thread_count;
+              benchmark_case.item_count_ = (double)grid_mesh.graph_.vertices_.size();
+              benchmark_case.item_name_ = "vertices";
+
+              std::vector<glm::vec2> solved_vertices;
+
+              runner.Measure(benchmark_case, [&] {
+                grid_mesh_solver.Solve(target_vertices, solved_vertices);
+              });
+            }
+
+            if (runner.IsSelected("cpu_render")) {
+              CPURenderBackend render_backend;
+
+              BenchmarkCase benchmark_case("cpu_render", image_size);
+              benchmark_case.pixel_type_ = pixel_type;
+              benchmark_case.grid_size_ = grid_size;
+              benchmark_case.thread_count_ = thread_count;
+              benchmark_case.item_count_ = pixel_count;
+              benchmark_case.item_name_ = "pixels";
+
+              runner.Measure(benchmark_case, [&] {
+                render_backend.Render(source_image, grid_mesh, warped_vertices, DEFAULT_WARPING_TEXTURE_FILTER);
+              });
+            }
+
+            if (runner.IsSelected("morph")) {
+              MorphEngine morph_engine(std::unique_ptr<RenderBackend>(new CPURenderBackend()));
+              morph_engine.options_.grid_size_ = grid_size;
+              morph_engine.options_.solver_thread_count_ = thread_count;
+
+              BenchmarkCase benchmark_case("morph", image_size);
+              benchmark_case.pixel_type_ = pixel_type;
+              benchmark_case.line_count_ = max_line_count;
+              benchmark_case.grid_size_ = grid_size;
+              benchmark_case.thread_count_ = thread_count;
+              benchmark_case.item_count_ = pixel_count;
+              benchmark_case.item_name_ = "pixels";
+
+              runner.Measure(benchmark_case, [&] {
+                morph_engine.Morphing(source_image, destination_image, 0.5, source_feature_lines, destination_feature_lines);
+              });
+            }
+
+            if (runner.IsSelected("morph_motion_blur")) {
+              MorphEngine morph_engine(std::unique_ptr<RenderBackend>(new CPURenderBackend()));
+              morph_engine.options_.grid_size_ = grid_size;
+              morph_engine.options_.solver_thread_count_ = thread_count;
+              morph_engine.options_.motion_blur_sub_frame_count_ = MOTION_BLUR_SUB_FRAME_COUNT;
+
+              BenchmarkCase benchmark_case("morph_motion_blur", image_size);
+              benchmark_case.pixel_type_ = pixel_type;
+              benchmark_case.line_count_ = max_line_count;
+              benchmark_case.grid_size_ = grid_size;
+              benchmark_case.thread_count_ = thread_count;
+              benchmark_case.item_count_ = pixel_count;
+              benchmark_case.item_name_ = "pixels";
+
+              runner.Measure(benchmark_case, [&] {
+                morph_engine.MorphingMotionBlur(source_image, destination_image, 0.5, MOTION_BLUR_SHUTTER_T, source_feature_lines, destination_feature_lines);
+              });
+            }
+
+            if (runner.IsSelected("morph_pairs")) {
+              MorphSequenceRenderer sequence_renderer([] {
+                return std::unique_ptr<RenderBackend>(new CPURenderBackend());
+              }, thread_count);
+              sequence_renderer.options_.grid_size_ = grid_size;
+
+              const std::vector<double> ts(std::begin(MORPH_PAIR_TS), std::end(MORPH_PAIR_TS));
+
+              BenchmarkCase benchmark_case("morph_pairs", image_size);
+              benchmark_case.pixel_type_ = pixel_type;
+              benchmark_case.line_count_ = max_line_count;
+              benchmark_case.grid_size_ = grid_size;
+              benchmark_case.thread_count_ = thread_count;
+              benchmark_case.item_count_ = pixel_count * MORPH_PAIR_COUNT * ts.size();
+              benchmark_case.item_name_ = "pixels";
+
+              size_t failed_frame_count = 0;
+
+              runner.Measure(benchmark_case, [&] {
+                sequence_renderer.RenderPairs(MORPH_PAIR_COUNT, [&](const size_t pair_index) {
+                  MorphPair morph_pair;
+                  const bool is_reversed = pair_index % 2 != 0;
+                  morph_pair.source_image_ = is_reversed ? destination_image : source_image;
+                  morph_pair.destination_image_ = is_reversed ? source_image : destination_image;
+                  morph_pair.source_feature_lines_ = is_reversed ? destination_feature_lines : source_feature_lines;
+                  morph_pair.destination_feature_lines_ = is_reversed ? source_feature_lines : destination_feature_lines;
+                  return morph_pair;
+                }, ts, image_size, [&](const size_t, const size_t, const cv::Mat &frame) {
+                  failed_frame_count += frame.empty();
+                });
+              });
+
+              if (failed_frame_count) {
+                std::cerr << "morph_pairs: " << failed_frame_count << " frames could not be morphed.\n";
+              }
+            }
+          }
+        }
+
+        if (runner.IsSelected("cross_dissolve")) {
+          for (const size_t thread_count : options.thread_counts_) {
+            omp_set_num_threads((int)thread_count);
+
+            BenchmarkCase benchmark_case("cross_dissolve", image_size);
+            benchmark_case.pixel_type_ = pixel_type;
+            benchmark_case.thread_count_ = thread_count;
+            benchmark_case.item_count_ = pixel_count;
+            benchmark_case.item_name_ = "pixels";
+
+            runner.Measure(benchmark_case, [&] {
+              CrossDissolve(source_image, destination_image, 0.5);
+            });
+          }
+        }
+
+        if (runner.IsSelected("cross_dissolve_linear_light") && source_image.depth() == CV_8U) {
+          for (const size_t thread_count : options.thread_counts_) {
+            omp_set_num_threads((int)thread_count);
+
+            BenchmarkCase benchmark_case("cross_dissolve_linear_light", image_size);
+            benchmark_case.pixel_type_ = pixel_type;
+            benchmark_case.thread_count_ = thread_count;
+            benchmark_case.item_count_ = pixel_count;
+            benchmark_case.item_name_ = "pixels";
+
+            // The table is built once, as the engine does for all the images of a frame
+            const LinearLightBlendTable blend_table(0.5);
+            cv::Mat result_image(source_image.size(), source_image.type());
+
+            runner.Measure(benchmark_case, [&] {
+              CrossDissolve(source_image, destination_image, blend_table, result_image);
+            });
+          }
+        }
+      }
+    }
+
+    return EXIT_CODE_SUCCESS;
+  }
+
+}
+
+int main(int argc, char **argv) {
+  return ImageMorphing::Run(argc, argv);
+}
@@ -0,0 +1,588 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "binary_feature_file.h"
+#include "cpu_render_backend.h"
+#include "feature_io.h"
+#include "frame_sink.h"
+#include "image_resampling.h"
+#include "image_store.h"
+#include "linear_light.h"
+#include "morph_engine.h"
+#include "morph_sequence.h"
+#include "morph_sequence_renderer.h"
+#include "pixel_format.h"
+#include "profiler.h"
+#include "raw_image_file.h"
+
+namespace ImageMorphing {
+
+  enum ExitCode {
+    EXIT_CODE_SUCCESS = 0,
+    EXIT_CODE_USAGE = 1,
+    EXIT_CODE_INPUT = 2,
+    EXIT_CODE_OUTPUT = 3
+  };
+
+  const size_t DEFAULT_FRAME_COUNT = 30;
+
+  const double DEFAULT_TILED_T = 0.5;
+
+  struct CommandLineOptions {
+
+    CommandLineOptions() : preview_level_(DEFAULT_PREVIEW_LEVEL), frame_count_(DEFAULT_FRAME_COUNT), thread_count_(0), max_resident_images_(0),
+      image_type_(CV_8UC3), t_(DEFAULT_TILED_T), tile_size_(DEFAULT_WARP_TILE_SIZE), max_grid_vertex_count_(DEFAULT_TILED_MAX_GRID_VERTEX_COUNT) {
+    }
+
+    std::vector<std::string> image_paths_;
+    std::string features_path_;
+    std::string output_path_;
+
+    // Optional output of a low resolution preview of the sequence, written before the full frames are morphed
+    std::string preview_output_path_;
+    size_t preview_level_;
+
+    size_t frame_count_;
+
+    // Threads morphing frames, 0 for every hardware thread. The video is encoded on another one.
+    size_t thread_count_;
+
+    // Source images held in memory at once, 0 keeps all of them
+    size_t max_resident_images_;
+
+    // Size of the frames, every image is fitted to it (see FitImage). Empty for CommonFrameSize of the images.
+    cv::Size frame_size_;
+
+    // Pixel type the images are decoded to and morphed in
+    int image_type_;
+
+    // Raw image inputs are morphed into a single raw image at t_, tile by tile
+    double t_;
+    int tile_size_;
+    size_t max_grid_vertex_count_;
+
+    MorphOptions morph_options_;
+
+    FrameSinkOptions frame_sink_options_;
+
+    // Profiling is enabled when any of them is set
+    std::string profile_path_;
+    std::string trace_path_;
+  };
+
+  void PrintUsage() {
+    std::cerr <<
+      "Usage: morph_cli --images <image> <image> [<image> ...] --features <file> --output <output>\n"
+      "                 [--frames <count>] [--fps <fps>] [--codec <fourcc>] [--encoder-threads <count>]\n"
+      "                 [--a <a>] [--b <b>] [--p <p>] [--grid-size <pixels>] [--blend <space>]\n"
+      "                 [--motion-blur <sub-frames>] [--shutter <fraction>]\n"
+      "                 [--threads <count>] [--max-resident-images <count>] [--size <width>x<height>] [--pixel-type <type>]\n"
+      "                 [--preview <output>] [--preview-level <level>] [--profile <file>] [--trace <file>]\n"
+      "       morph_cli --images <raw image> <raw image> --features <file> --output <raw image>\n"
+      "                 [--t <t>] [--tile-size <pixels>] [--max-grid-vertices <count>]\n"
+      "                 [--a <a>] [--b <b>] [--p <p>] [--grid-size <pixels>] [--blend <space>] [--profile <file>] [--trace <file>]\n"
+      "\n"
+      "  --images     Images to morph through, in order.\n"
+      "  --features   Feature line file, as saved by Image Morphing, text or binary (" << BINARY_FEATURE_FILE_EXTENSION << ").\n"
+      "  --output     One of\n"
+      "                 " << STDOUT_OUTPUT << "             raw BGR (or BGRA) frames to stdout\n"
+      "                 " << RAW_OUTPUT_PREFIX << "<path>    raw BGR (or BGRA) frames to a file or named pipe\n"
+      "                 <dir>/%05d.png  numbered images, PNG or JPEG after the extension\n"
+      "                 <video>         video file\n"
+      "  --frames     Frames from one image to the next (default " << DEFAULT_FRAME_COUNT << ").\n"
+      "  --fps        Frame rate of the output video (default " << DEFAULT_VIDEO_FPS << ").\n"
+      "  --codec      FOURCC of the output video (default " << DEFAULT_VIDEO_FOURCC << ").\n"
+      "  --encoder-threads\n"
+      "               Threads encoding numbered images (default every core).\n"
+      "  --a --b --p  Weights of the feature lines (default 1, 2, 0).\n"
+      "  --grid-size  Size of a cell of the warped mesh (default " << MESH_GRID_SIZE << ").\n"
+      "  --blend      gamma (default) to cross dissolve the stored values, or linear to decode 8-bit images\n"
+      "               from sRGB first, so midtones keep their brightness through the transition.\n"
+      "  --motion-blur\n"
+      "               Sub-frames averaged into every frame (default 1, sharp frames). Only the first and the last\n"
+      "               sub-frame of a frame solve a mesh, so a sub-frame costs far less than a frame.\n"
+      "  --shutter    Fraction of the time between two frames the sub-frames are spread over (default " << DEFAULT_MOTION_BLUR_SHUTTER << ").\n"
+      "  --threads    Threads morphing frames while the video is encoded (default every core).\n"
+      "  --max-resident-images\n"
+      "               Source images kept in memory at once, at least 2 (default all of them).\n"
+      "  --size       Size of the frames. Images and feature lines are scaled, keeping their aspect ratio,\n"
+      "               until they cover it, with area averaging when shrinking and Lanczos when enlarging,\n"
+      "               and what sticks out is cropped evenly on both sides. Default: the largest size with\n"
+      "               the aspect ratio of the first image that every image covers, so nothing is enlarged.\n"
+      "  --pixel-type bgr8 (default), or bgra8 to keep the alpha of the images. Alpha is premultiplied while\n"
+      "               morphing, numbered images and raw frames get it back straight, videos are shown over black.\n"
+      "               bgr16 and bgr32f keep the depth of 16-bit and float images, numbered images keep it in\n"
+      "               PNG and TIFF (16-bit) or EXR, TIFF and HDR (float) files, videos are 8-bit.\n"
+      "  --preview    Output of a preview, in any of the forms of --output. It is morphed and written\n"
+      "               first, frame by frame, then the full frames are morphed.\n"
+      "  --preview-level\n"
+      "               Preview frames are 2^level times smaller along each axis (default " << DEFAULT_PREVIEW_LEVEL << ").\n"
+      "  --profile    JSON file receiving the time spent in every stage and the counters of every frame.\n"
+      "  --trace      JSON file receiving every timed stage in the Chrome trace event format.\n"
+      "\n"
+      "  Raw images (" << RAW_IMAGE_FILE_EXTENSION << ") too large for memory are morphed into one raw image, one tile at a time.\n"
+      "  --t          Position of the result between the two images (default " << DEFAULT_TILED_T << ").\n"
+      "  --tile-size  Side of the output tiles (default " << DEFAULT_WARP_TILE_SIZE << "). Memory use grows with it.\n"
+      "  --max-grid-vertices\n"
+      "               The mesh is solved over the whole image, so images whose mesh at --grid-size would have more vertices\n"
+      "               get a coarser one (default " << DEFAULT_TILED_MAX_GRID_VERTEX_COUNT << ", 0 for no limit). Its memory grows with this count.\n";
+  }
+
+  bool ParseCommandLine(int argc, char **argv, CommandLineOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string argument = argv[i];
+
+      if (argument == "--images") {
+        while (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--")) {
+          options.image_paths_.push_back(argv[++i]);
+        }
+        continue;
+      }
+
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value of " << argument << ".\n";
+        return false;
+      }
+
+      const char *value = argv[++i];
+
+      if (argument == "--features") {
+        options.features_path_ = value;
+      } else if (argument == "--output") {
+        options.output_path_ = value;
+      } else if (argument == "--frames") {
+        options.frame_count_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--fps") {
+        options.frame_sink_options_.fps_ = std::atof(value);
+      } else if (argument == "--codec") {
+        options.frame_sink_options_.fourcc_ = value;
+      } else if (argument == "--encoder-threads") {
+        options.frame_sink_options_.encoder_thread_count_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--a") {
+        options.morph_options_.a_ = std::atof(value);
+      } else if (argument == "--b") {
+        options.morph_options_.b_ = std::atof(value);
+      } else if (argument == "--p") {
+        options.morph_options_.p_ = std::atof(value);
+      } else if (argument == "--threads") {
+        options.thread_count_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--max-resident-images") {
+        options.max_resident_images_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--preview") {
+        options.preview_output_path_ = value;
+      } else if (argument == "--preview-level") {
+        options.preview_level_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--profile") {
+        options.profile_path_ = value;
+      } else if (argument == "--trace") {
+        options.trace_path_ = value;
+      } else if (argument == "--size") {
+        if (std::sscanf(value, "%dx%d", &options.frame_size_.width, &options.frame_size_.height) != 2 ||
+          options.frame_size_.width <= 0 || options.frame_size_.height <= 0) {
+          std::cerr << "--size must be <width>x<height>.\n";
+          return false;
+        }
+      } else if (argument == "--pixel-type") {
+        if (!ParseImageType(value, options.image_type_)) {
+          std::cerr << "Unknown pixel type " << value << ".\n";
+          return false;
+        }
+      } else if (argument == "--blend") {
+        if (!ParseBlendSpace(value, options.morph_options_.blend_space_)) {
+          std::cerr << "Unknown blend space " << value << ".\n";
+          return false;
+        }
+      } else if (argument == "--motion-blur") {
+        options.morph_options_.motion_blur_sub_frame_count_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--shutter") {
+        options.morph_options_.motion_blur_shutter_ = std::atof(value);
+      } else if (argument == "--t") {
+        options.t_ = std::atof(value);
+      } else if (argument == "--tile-size") {
+        options.tile_size_ = std::atoi(value);
+      } else if (argument == "--max-grid-vertices") {
+        options.max_grid_vertex_count_ = std::strtoul(value, nullptr, 10);
+      } else if (argument == "--grid-size") {
+        options.morph_options_.grid_size_ = std::strtoul(value, nullptr, 10);
+      } else {
+        std::cerr << "Unknown option " << argument << ".\n";
+        return false;
+      }
+    }
+
+    if (options.image_paths_.size() < 2) {
+      std::cerr << "At least two images are needed.\n";
+      return false;
+    }
+
+    if (options.features_path_.empty() || options.output_path_.empty()) {
+      std::cerr << "Both --features and --output are needed.\n";
+      return false;
+    }
+
+    if (options.frame_sink_options_.fourcc_.size() != 4) {
+      std::cerr << "--codec must be a FOURCC of 4 characters.\n";
+      return false;
+    }
+
+    if (!options.frame_count_ || options.frame_sink_options_.fps_ <= 0 || !options.morph_options_.grid_size_ || options.tile_size_ <= 0) {
+      std::cerr << "--frames, --fps, --grid-size and --tile-size must be positive.\n";
+      return false;
+    }
+
+    if (!options.morph_options_.motion_blur_sub_frame_count_ || options.morph_options_.motion_blur_shutter_ < 0) {
+      std::cerr << "--motion-blur must be positive and --shutter must not be negative.\n";
+      return false;
+    }
+
+    if (options.t_ < 0 || options.t_ > 1) {
+      std::cerr << "--t must be in [0, 1].\n";
+      return false;
+    }
+
+    return true;
+  }
+
+  // Wall clock time spent in one stage of the pipeline. Reports go to stderr, stdout may carry the frames.
+  class StageTimer {
+
+  public:
+
+    StageTimer() : start_(std::chrono::steady_clock::now()) {
+    }
+
+    void Report(const std::string &stage_name) {
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      std::cerr << stage_name << ": " << std::chrono::duration<double, std::milli>(now - start_).count() << " ms\n";
+      start_ = now;
+    }
+
+  private:
+
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  // Loads the lines of images of image_sizes, moved onto the images fitted to frame_size.
+  // A binary file needing neither resampling nor padding is morphed straight from mapped_feature_file,
+  // otherwise the spans point into loaded_feature_lines_of_images. Both must outlive feature_lines_of_images.
+  int LoadFeatureLineSpans(const std::string &features_path, const std::vector<cv::Size> &image_sizes, const cv::Size &frame_size,
+    MappedFeatureFile &mapped_feature_file, std::vector<std::vector<FeatureLine> > &loaded_feature_lines_of_images,
+    std::vector<FeatureLineSpan> &feature_lines_of_images) {
+    const size_t image_count = image_sizes.size();
+
+    if (IsBinaryFeatureFile(features_path)) {
+      if (!mapped_feature_file.Open(features_path)) {
+        std::cerr << "Could not read feature file " << features_path << ".\n";
+        return EXIT_CODE_INPUT;
+      }
+      feature_lines_of_images = mapped_feature_file.FeatureLinesOfImages();
+    } else {
+      if (!LoadFeatureLines(features_path, loaded_feature_lines_of_images)) {
+        std::cerr << "Could not read feature file " << features_path << ".\n";
+        return EXIT_CODE_INPUT;
+      }
+      feature_lines_of_images.assign(loaded_feature_lines_of_images.begin(), loaded_feature_lines_of_images.end());
+    }
+
+    if (feature_lines_of_images.size() < image_count) {
+      std::cerr << "The feature file has lines for " << feature_lines_of_images.size() << " images, " << image_count << " are needed.\n";
+      return EXIT_CODE_INPUT;
+    }
+
+    feature_lines_of_images.resize(image_count);
+
+    const bool is_padding_needed = std::any_of(feature_lines_of_images.begin(), feature_lines_of_images.end(), [&](const FeatureLineSpan &feature_lines) {
+      return feature_lines.size() != feature_lines_of_images[0].size();
+    });
+
+    const bool is_resampling_needed = std::any_of(image_sizes.begin(), image_sizes.end(), [&](const cv::Size &image_size) {
+      return image_size != frame_size;
+    });
+
+    if (is_padding_needed || is_resampling_needed) {
+      // The spans may point into loaded_feature_lines_of_images, copy before replacing it.
+      // Padding borrows lines from other images, so it comes after the lines share the frame coordinates.
+      std::vector<std::vector<FeatureLine> > padded_feature_lines_of_images;
+      for (size_t image_index = 0; image_index < image_count; ++image_index) {
+        padded_feature_lines_of_images.push_back(FitFeatureLines(feature_lines_of_images[image_index], image_sizes[image_index], frame_size));
+      }
+      PadFeatureLines(padded_feature_lines_of_images);
+      loaded_feature_lines_of_images.swap(padded_feature_lines_of_images);
+      feature_lines_of_images.assign(loaded_feature_lines_of_images.begin(), loaded_feature_lines_of_images.end());
+    }
+
+    if (feature_lines_of_images[0].empty()) {
+      std::cerr << "The feature file has no feature line.\n";
+      return EXIT_CODE_INPUT;
+    }
+
+    return EXIT_CODE_SUCCESS;
+  }
+
+  // Morphs two raw images into a raw image without ever holding a whole image in memory
+  int RunTiled(const CommandLineOptions &options) {
+    StageTimer stage_timer;
+
+    if (options.image_paths_.size() != 2) {
+      std::cerr << "Raw images are morphed two at a time.\n";
+      return EXIT_CODE_USAGE;
+    }
+
+    MappedRawImage source_image;
+    MappedRawImage destination_image;
+
+    if (!source_image.Open(options.image_paths_[0]) || !destination_image.Open(options.image_paths_[1])) {
+      std::cerr << "Could not read raw images " << options.image_paths_[0] << " and " << options.image_paths_[1] << ".\n";
+      return EXIT_CODE_INPUT;
+    }
+
+    if (source_image.size() != destination_image.size() || source_image.type() != destination_image.type() || !IsSupportedImageType(source_image.type())) {
+      std::cerr << "Raw images must be 8-bit BGR or BGRA, 16-bit BGR or float BGR images of the same size and type.\n";
+      return EXIT_CODE_INPUT;
+    }
+
+    MappedFeatureFile mapped_feature_file;
+    std::vector<std::vector<FeatureLine> > loaded_feature_lines_of_images;
+    std::vector<FeatureLineSpan> feature_lines_of_images;
+
+    const std::vector<cv::Size> image_sizes(2, source_image.size());
+
+    const int load_exit_code = LoadFeatureLineSpans(options.features_path_, image_sizes, source_image.size(), mapped_feature_file, loaded_feature_lines_of_images, feature_lines_of_images);
+    if (load_exit_code != EXIT_CODE_SUCCESS) {
+      return load_exit_code;
+    }
+
+    MappedRawImage result_image;
+
+    if (!result_image.Create(options.output_path_, source_image.size(), source_image.type())) {
+      std::cerr << "Could not create raw image " << options.output_path_ << ".\n";
+      return EXIT_CODE_OUTPUT;
+    }
+
+    stage_timer.Report("Load");
+
+    MorphEngine morph_engine(std::unique_ptr<RenderBackend>(new CPURenderBackend()));
+    morph_engine.options_ = options.morph_options_;
+    morph_engine.options_.max_grid_vertex_count_ = options.max_grid_vertex_count_;
+
+    if (!morph_engine.MorphingTiled(source_image, destination_image, options.t_, feature_lines_of_images[0], feature_lines_of_images[1], result_image, options.tile_size_)) {
+      std::cerr << "Could not morph into raw image " << options.output_path_ << ".\n";
+      return EXIT_CODE_OUTPUT;
+    }
+
+    stage_timer.Report("Morph");
+
+    std::cerr << "Morphed " << source_image.size().width << " x " << source_image.size().height << " pixels into " << options.output_path_ << ".\n";
+
+    return EXIT_CODE_SUCCESS;
+  }
+
+  int RunSequence(const CommandLineOptions &options) {
+    StageTimer total_timer;
+    StageTimer stage_timer;
+
+    const size_t image_count = options.image_paths_.size();
+
+    ImageStore image_store;
+    std::vector<cv::Size> image_sizes;
+
+    for (size_t image_index = 0; image_index < image_count; ++image_index) {
+      // With a memory budget the images are decoded when needed, their sizes come from the file headers where the format allows
+      cv::Size image_size;
+      if (options.max_resident_images_ && ReadImageSize(options.image_paths_[image_index], image_size)) {
+        image_sizes.push_back(image_size);
+        continue;
+      }
+
+      cv::Mat image = ReadImage(options.image_paths_[image_index], options.image_type_);
+      if (image.empty()) {
+        std::cerr << "Could not read image " << options.image_paths_[image_index] << ".\n";
+        return EXIT_CODE_INPUT;
+      }
+
+      image_sizes.push_back(image.size());
+
+      if (!options.max_resident_images_) {
+        image_store.Add(image);
+      }
+    }
+
+    const cv::Size frame_size = options.frame_size_.area() ? options.frame_size_ : CommonFrameSize(image_sizes);
+
+    // Every image is resampled once, up front, rather than warped at its own size
+    std::vector<cv::Mat> images;
+
+    for (size_t image_index = 0; image_index < image_store.ImageCount(); ++image_index) {
+      images.push_back(image_store.Resampled(image_index, frame_size));
+    }
+
+    // Only the resampled images are needed from here on
+    image_store.Clear();
+
+    MappedFeatureFile mapped_feature_file;
+    std::vector<std::vector<FeatureLine> > loaded_feature_lines_of_images;
+    std::vector<FeatureLineSpan> feature_lines_of_images;
+
+    const int load_exit_code = LoadFeatureLineSpans(options.features_path_, image_sizes, frame_size, mapped_feature_file, loaded_feature_lines_of_images, feature_lines_of_images);
+    if (load_exit_code != EXIT_CODE_SUCCESS) {
+      return load_exit_code;
+    }
+
+    stage_timer.Report("Load");
+
+    std::unique_ptr<FrameSink> frame_sink = CreateFrameSink(options.output_path_, options.frame_sink_options_);
+
+    if (!frame_sink->Open(frame_size)) {
+      std::cerr << "Could not open output " << options.output_path_ << ".\n";
+      return EXIT_CODE_OUTPUT;
+    }
+
+    MorphSequenceRenderer sequence_renderer([] {
+      return std::unique_ptr<RenderBackend>(new CPURenderBackend());
+    }, options.thread_count_);
+    sequence_renderer.options_ = options.morph_options_;
+    sequence_renderer.max_resident_images_ = options.max_resident_images_;
+
+    std::atomic<bool> is_image_missing(false);
+
+    auto load_image = [&](const size_t image_index) {
+      if (!images.empty()) {
+        return images[image_index];
+      }
+
+      cv::Mat image = ReadImage(options.image_paths_[image_index], options.image_type_);
+      if (image.size() != image_sizes[image_index]) {
+        // The pixels cannot be decoded or the file changed since its size was read, keep the video going with a black image
+        is_image_missing = true;
+        return cv::Mat(frame_size, options.image_type_, cv::Scalar::all(0));
+      }
+
+      return FitImage(image, frame_size);
+    };
+
+    size_t written_frame_count = 0;
+    size_t consumed_frame_count = 0;
+    double encode_milliseconds = 0;
+    bool is_output_good = true;
+
+    auto consume = [&](const cv::Mat &frame_at_t) {
+      // Frames arrive in order, so the encode is attributed to the frame the renderer morphed
+      MORPH_PROFILE_FRAME(consumed_frame_count++);
+
+      std::chrono::steady_clock::time_point encode_start = std::chrono::steady_clock::now();
+
+      if (is_output_good && frame_sink->Write(frame_at_t)) {
+        ++written_frame_count;
+      } else {
+        is_output_good = false;
+      }
+
+      encode_milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encode_start).count();
+    };
+
+    if (options.preview_output_path_.empty()) {
+      sequence_renderer.Render(image_count, load_image, feature_lines_of_images, options.frame_count_, consume);
+    } else {
+      std::unique_ptr<FrameSink> preview_frame_sink = CreateFrameSink(options.preview_output_path_, options.frame_sink_options_);
+
+      if (!preview_frame_sink->Open(PreviewFrameSize(frame_size, options.preview_level_))) {
+        std::cerr << "Could not open preview output " << options.preview_output_path_ << ".\n";
+        return EXIT_CODE_OUTPUT;
+      }
+
+      bool is_preview_good = true;
+      bool is_preview_closed = false;
+      size_t preview_frames_left = MorphSequenceFrames(image_count, options.frame_count_).size();
+
+      sequence_renderer.RenderProgressive(image_count, load_image, feature_lines_of_images, options.frame_count_, frame_size, options.preview_level_,
+        [&](const cv::Mat &preview_frame_at_t) {
+        is_preview_good = is_preview_good && preview_frame_sink->Write(preview_frame_at_t);
+
+        // The whole preview is out before the first full frame is morphed
+        if (!--preview_frames_left) {
+          is_preview_good = preview_frame_sink->Close() && is_preview_good;
+          is_preview_closed = true;
+          stage_timer.Report("Preview");
+        }
+      }, consume);
+
+      if (!is_preview_closed) {
+        is_preview_good = preview_frame_sink->Close() && is_preview_good;
+      }
+
+      if (!is_preview_good) {
+        std::cerr << "Could not write every preview frame to " << options.preview_output_path_ << ".\n";
+        is_output_good = false;
+      }
+    }
+
+    is_output_good = frame_sink->Close() && is_output_good;
+
+    stage_timer.Report("Morph and encode");
+
+    // Encoding overlaps with morphing, this is the time the consumer thread spent handing frames to the sink
+    std::cerr << "  Encode: " << encode_milliseconds << " ms\n";
+    std::cerr << "  Workers: " << sequence_renderer.threading_.worker_count_ << " x " << sequence_renderer.threading_.thread_count_per_worker_ << " threads\n";
+    total_timer.Report("Total");
+
+    std::cerr << written_frame_count << " frames written to " << options.output_path_ << ".\n";
+
+    if (!is_output_good) {
+      std::cerr << "Could not write every frame to " << options.output_path_ << ".\n";
+      return EXIT_CODE_OUTPUT;
+    }
+
+    if (is_image_missing) {
+      std::cerr << "An image could not be read while morphing.\n";
+      return EXIT_CODE_INPUT;
+    }
+
+    return EXIT_CODE_SUCCESS;
+  }
+
+  int Run(int argc, char **argv) {
+    CommandLineOptions options;
+
+    if (!ParseCommandLine(argc, argv, options)) {
+      PrintUsage();
+      return EXIT_CODE_USAGE;
+    }
+
+    const bool is_profiling = !options.profile_path_.empty() || !options.trace_path_.empty();
+
+    if (is_profiling) {
+      ResetProfile();
+      EnableProfiling(true);
+    }
+
+    const int exit_code = IsRawImageFile(options.image_paths_[0]) ? RunTiled(options) : RunSequence(options);
+
+    if (is_profiling) {
+      EnableProfiling(false);
+
+      if (!options.profile_path_.empty() && !SaveProfileJSON(options.profile_path_)) {
+        std::cerr << "Could not write the profile to " << options.profile_path_ << ".\n";
+      }
+
+      if (!options.trace_path_.empty() && !SaveProfileChromeTrace(options.trace_path_)) {
+        std::cerr << "Could not write the trace to " << options.trace_path_ << ".\n";
+      }
+    }
+
+    return exit_code;
+  }
+
+}
+
+int main(int argc, char **argv) {
+  return ImageMorphing::Run(argc, argv);
+}
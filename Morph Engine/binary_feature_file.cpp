@@ -0,0 +1,159 @@
+#include "binary_feature_file.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    const size_t PAYLOAD_ALIGNMENT = 8;
+
+    size_t ScalarSize(const FeatureScalarType scalar_type) {
+      return scalar_type == FeatureScalarType::FLOAT32 ? sizeof(float) : sizeof(double);
+    }
+
+    uint64_t AlignOffset(const uint64_t offset) {
+      return (offset + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+    }
+
+  }
+
+  MappedFeatureFile::MappedFeatureFile() {
+  }
+
+  MappedFeatureFile::~MappedFeatureFile() {
+  }
+
+  bool MappedFeatureFile::Open(const std::string &file_path) {
+    Close();
+
+    if (!mapped_file_.Open(file_path)) {
+      return false;
+    }
+
+    const char *data = mapped_file_.data();
+    const size_t size = mapped_file_.size();
+
+    BinaryFeatureFileHeader header;
+    if (size < sizeof(header)) {
+      Close();
+      return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic_, BINARY_FEATURE_FILE_MAGIC, sizeof(header.magic_)) || header.version_ != BINARY_FEATURE_FILE_VERSION ||
+      header.scalar_type_ > (uint32_t)FeatureScalarType::FLOAT64 || (size - sizeof(header)) / sizeof(BinaryFeatureFileImageEntry) < header.image_count_) {
+      Close();
+      return false;
+    }
+
+    const FeatureScalarType scalar_type = (FeatureScalarType)header.scalar_type_;
+    const size_t line_size = 4 * ScalarSize(scalar_type);
+
+    std::vector<BinaryFeatureFileImageEntry> image_entries(header.image_count_);
+    if (header.image_count_) {
+      std::memcpy(image_entries.data(), data + sizeof(header), image_entries.size() * sizeof(BinaryFeatureFileImageEntry));
+    }
+
+    for (const auto &image_entry : image_entries) {
+      if (image_entry.offset_ % PAYLOAD_ALIGNMENT || image_entry.offset_ > size || (size - image_entry.offset_) / line_size < image_entry.line_count_) {
+        Close();
+        return false;
+      }
+    }
+
+    if (scalar_type == FeatureScalarType::FLOAT64) {
+      for (const auto &image_entry : image_entries) {
+        feature_lines_of_images_.push_back(FeatureLineSpan((const FeatureLine *)(data + image_entry.offset_), (size_t)image_entry.line_count_));
+      }
+      return true;
+    }
+
+    converted_feature_lines_of_images_.resize(image_entries.size());
+
+    for (size_t image_index = 0; image_index < image_entries.size(); ++image_index) {
+      const float *scalars = (const float *)(data + image_entries[image_index].offset_);
+      std::vector<FeatureLine> &feature_lines = converted_feature_lines_of_images_[image_index];
+
+      feature_lines.resize((size_t)image_entries[image_index].line_count_);
+
+      for (size_t i = 0; i < feature_lines.size(); ++i, scalars += 4) {
+        feature_lines[i] = FeatureLine(cv::Point2d(scalars[0], scalars[1]), cv::Point2d(scalars[2], scalars[3]));
+      }
+
+      feature_lines_of_images_.push_back(feature_lines);
+    }
+
+    // Nothing points into the file any more
+    mapped_file_.Close();
+
+    return true;
+  }
+
+  void MappedFeatureFile::Close() {
+    feature_lines_of_images_.clear();
+    converted_feature_lines_of_images_.clear();
+    mapped_file_.Close();
+  }
+
+  bool IsBinaryFeatureFile(const std::string &file_path) {
+    std::ifstream input_stream(file_path, std::ios::binary);
+
+    char magic[sizeof(BINARY_FEATURE_FILE_MAGIC)];
+    return input_stream.read(magic, sizeof(magic)) && !std::memcmp(magic, BINARY_FEATURE_FILE_MAGIC, sizeof(magic));
+  }
+
+  bool SaveBinaryFeatureLines(const std::string &file_path, const std::vector<FeatureLineSpan> &feature_lines_of_images, const FeatureScalarType scalar_type) {
+    std::ofstream output_stream(file_path, std::ios::binary);
+    if (!output_stream) {
+      return false;
+    }
+
+    BinaryFeatureFileHeader header;
+    std::memcpy(header.magic_, BINARY_FEATURE_FILE_MAGIC, sizeof(header.magic_));
+    header.version_ = BINARY_FEATURE_FILE_VERSION;
+    header.scalar_type_ = (uint32_t)scalar_type;
+    header.image_count_ = (uint32_t)feature_lines_of_images.size();
+
+    const size_t line_size = 4 * ScalarSize(scalar_type);
+
+    std::vector<BinaryFeatureFileImageEntry> image_entries(feature_lines_of_images.size());
+
+    uint64_t offset = AlignOffset(sizeof(header) + image_entries.size() * sizeof(BinaryFeatureFileImageEntry));
+
+    for (size_t image_index = 0; image_index < image_entries.size(); ++image_index) {
+      image_entries[image_index].offset_ = offset;
+      image_entries[image_index].line_count_ = feature_lines_of_images[image_index].size();
+      offset = AlignOffset(offset + feature_lines_of_images[image_index].size() * line_size);
+    }
+
+    output_stream.write((const char *)&header, sizeof(header));
+    if (!image_entries.empty()) {
+      output_stream.write((const char *)image_entries.data(), image_entries.size() * sizeof(BinaryFeatureFileImageEntry));
+    }
+
+    uint64_t written_size = sizeof(header) + image_entries.size() * sizeof(BinaryFeatureFileImageEntry);
+    const char padding[PAYLOAD_ALIGNMENT] = {};
+
+    for (size_t image_index = 0; image_index < image_entries.size(); ++image_index) {
+      output_stream.write(padding, (std::streamsize)(image_entries[image_index].offset_ - written_size));
+
+      const FeatureLineSpan &feature_lines = feature_lines_of_images[image_index];
+
+      if (scalar_type == FeatureScalarType::FLOAT64) {
+        output_stream.write((const char *)feature_lines.begin(), feature_lines.size() * line_size);
+      } else {
+        for (const auto &feature_line : feature_lines) {
+          const float scalars[4] = {(float)feature_line.first.x, (float)feature_line.first.y, (float)feature_line.second.x, (float)feature_line.second.y};
+          output_stream.write((const char *)scalars, sizeof(scalars));
+        }
+      }
+
+      written_size = image_entries[image_index].offset_ + feature_lines.size() * line_size;
+    }
+
+    return (bool)output_stream;
+  }
+
+}
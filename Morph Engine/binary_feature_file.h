@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "feature_line.h"
+#include "memory_mapped_file.h"
+
+namespace ImageMorphing {
+
+  // Binary feature file, little endian:
+  //   BinaryFeatureFileHeader
+  //   BinaryFeatureFileImageEntry for each image
+  //   the lines of every image as packed x1 y1 x2 y2, each run aligned to 8 bytes
+  const char BINARY_FEATURE_FILE_MAGIC[4] = {'M', 'F', 'L', 'B'};
+  const uint32_t BINARY_FEATURE_FILE_VERSION = 1;
+
+  const std::string BINARY_FEATURE_FILE_EXTENSION = ".mfl";
+
+  // Double precision lines are read in place from the mapping and written straight from memory,
+  // so a FeatureLine must be exactly the x1 y1 x2 y2 of the file
+  static_assert(sizeof(FeatureLine) == 4 * sizeof(double), "FeatureLine must be 4 packed doubles to be stored as they are");
+  static_assert(std::is_standard_layout<FeatureLine>::value && std::is_standard_layout<cv::Point2d>::value,
+    "FeatureLine must be standard layout to be stored as it is");
+
+  enum class FeatureScalarType : uint32_t {
+    FLOAT32 = 0,
+    FLOAT64 = 1
+  };
+
+  struct BinaryFeatureFileHeader {
+    char magic_[4];
+    uint32_t version_;
+    uint32_t scalar_type_;
+    uint32_t image_count_;
+  };
+
+  struct BinaryFeatureFileImageEntry {
+    // From the start of the file
+    uint64_t offset_;
+    uint64_t line_count_;
+  };
+
+  // Read-only memory mapping of a binary feature file. Double precision lines are used in place, without any copy;
+  // single precision lines are widened once when the file is opened.
+  class MappedFeatureFile {
+
+  public:
+
+    MappedFeatureFile();
+
+    ~MappedFeatureFile();
+
+    // Fails on a missing file, a foreign format or a version this build cannot read
+    bool Open(const std::string &file_path);
+
+    void Close();
+
+    size_t ImageCount() const {
+      return feature_lines_of_images_.size();
+    }
+
+    // Valid until Close or destruction
+    FeatureLineSpan FeatureLines(const size_t image_index) const {
+      return feature_lines_of_images_[image_index];
+    }
+
+    const std::vector<FeatureLineSpan> &FeatureLinesOfImages() const {
+      return feature_lines_of_images_;
+    }
+
+  private:
+
+    MappedFeatureFile(const MappedFeatureFile &) = delete;
+    MappedFeatureFile &operator =(const MappedFeatureFile &) = delete;
+
+    MemoryMappedFile mapped_file_;
+
+    std::vector<FeatureLineSpan> feature_lines_of_images_;
+
+    // Widened lines of single precision files
+    std::vector<std::vector<FeatureLine> > converted_feature_lines_of_images_;
+  };
+
+  bool IsBinaryFeatureFile(const std::string &file_path);
+
+  bool SaveBinaryFeatureLines(const std::string &file_path, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+    const FeatureScalarType scalar_type = FeatureScalarType::FLOAT64);
+
+}
@@ -0,0 +1,147 @@
+#include "cpu_render_backend.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <omp.h>
+
+#include "pixel_kernels.h"
+#include "profiler.h"
+
+namespace ImageMorphing {
+
+  namespace {
+
+    inline double EdgeFunction(const cv::Point2d &a, const cv::Point2d &b, const cv::Point2d &q) {
+      return (b.x - a.x) * (q.y - a.y) - (b.y - a.y) * (q.x - a.x);
+    }
+
+    // Pixels exactly on an edge shared by two triangles belong to only one of them
+    inline bool IsTopLeftEdge(const cv::Point2d &a, const cv::Point2d &b) {
+      return (a.y == b.y && b.x > a.x) || b.y < a.y;
+    }
+
+    inline bool IsInsideEdge(double w, bool is_top_left_edge) {
+      return w > 0 || (w == 0 && is_top_left_edge);
+    }
+
+    template <typename T, int channel_count>
+    void RasterizeTrianglePixels(const cv::Mat &source_image, cv::Mat &warped_image, cv::Point2d positions[3], cv::Point2d source_positions[3],
+      const TextureFilter texture_filter) {
+      double area = EdgeFunction(positions[0], positions[1], positions[2]);
+
+      if (std::abs(area) < 1e-12) {
+        return;
+      }
+
+      if (area < 0) {
+        std::swap(positions[1], positions[2]);
+        std::swap(source_positions[1], source_positions[2]);
+        area = -area;
+      }
+
+      const bool is_top_left_edge[3] = {
+        IsTopLeftEdge(positions[1], positions[2]),
+        IsTopLeftEdge(positions[2], positions[0]),
+        IsTopLeftEdge(positions[0], positions[1])
+      };
+
+      double min_x = std::min(positions[0].x, std::min(positions[1].x, positions[2].x));
+      double max_x = std::max(positions[0].x, std::max(positions[1].x, positions[2].x));
+      double min_y = std::min(positions[0].y, std::min(positions[1].y, positions[2].y));
+      double max_y = std::max(positions[0].y, std::max(positions[1].y, positions[2].y));
+
+      // Pixel (c, r) is sampled at its center (c + 0.5, r + 0.5)
+      int first_column = std::max(0, (int)std::ceil(min_x - 0.5));
+      int last_column = std::min(warped_image.cols - 1, (int)std::floor(max_x - 0.5));
+      int first_row = std::max(0, (int)std::ceil(min_y - 0.5));
+      int last_row = std::min(warped_image.rows - 1, (int)std::floor(max_y - 0.5));
+
+      for (int r = first_row; r <= last_row; ++r) {
+        for (int c = first_column; c <= last_column; ++c) {
+          cv::Point2d pixel_center(c + 0.5, r + 0.5);
+
+          double w0 = EdgeFunction(positions[1], positions[2], pixel_center);
+          double w1 = EdgeFunction(positions[2], positions[0], pixel_center);
+          double w2 = EdgeFunction(positions[0], positions[1], pixel_center);
+
+          if (!IsInsideEdge(w0, is_top_left_edge[0]) || !IsInsideEdge(w1, is_top_left_edge[1]) || !IsInsideEdge(w2, is_top_left_edge[2])) {
+            continue;
+          }
+
+          cv::Point2d source_position = (w0 * source_positions[0] + w1 * source_positions[1] + w2 * source_positions[2]) / area;
+
+          source_position.x = std::min(source_image.cols - 1.0, std::max(0.0, source_position.x - 0.5));
+          source_position.y = std::min(source_image.rows - 1.0, std::max(0.0, source_position.y - 0.5));
+
+          SampleTo<T, channel_count>(source_image, source_position, texture_filter, warped_image.ptr<T>(r) + c * channel_count);
+        }
+      }
+    }
+
+  }
+
+  void WarpedTrianglePositions(const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices, const size_t triangle_index,
+    cv::Point2d positions[3], cv::Point2d source_positions[3]) {
+    const double width = grid_mesh.image_size_.width;
+    const double height = grid_mesh.image_size_.height;
+
+    for (size_t k = 0; k < 3; ++k) {
+      size_t vertex_index = grid_mesh.indices_[triangle_index * 3 + k];
+
+      // The mesh is in OpenGL coordinates, with the y axis pointing up
+      positions[k] = cv::Point2d(warped_vertices[vertex_index].x, height - warped_vertices[vertex_index].y);
+      source_positions[k] = cv::Point2d(grid_mesh.uvs_[vertex_index].x * width, (1.0 - grid_mesh.uvs_[vertex_index].y) * height);
+    }
+  }
+
+  void RasterizeTriangle(const cv::Mat &source_image, cv::Mat &warped_image, cv::Point2d positions[3], cv::Point2d source_positions[3],
+    const TextureFilter texture_filter) {
+    switch (source_image.type()) {
+    case CV_8UC3:
+      RasterizeTrianglePixels<uchar, 3>(source_image, warped_image, positions, source_positions, texture_filter);
+      break;
+    case CV_8UC4:
+      RasterizeTrianglePixels<uchar, 4>(source_image, warped_image, positions, source_positions, texture_filter);
+      break;
+    case CV_16UC3:
+      RasterizeTrianglePixels<ushort, 3>(source_image, warped_image, positions, source_positions, texture_filter);
+      break;
+    case CV_32FC3:
+      RasterizeTrianglePixels<float, 3>(source_image, warped_image, positions, source_positions, texture_filter);
+      break;
+    }
+  }
+
+  cv::Mat CPURenderBackend::Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+    const TextureFilter texture_filter) {
+    cv::Mat warped_image = frame_arena_.Image(source_image.size(), source_image.type());
+    Render(source_image, grid_mesh, warped_vertices, texture_filter, warped_image);
+    return warped_image;
+  }
+
+  void CPURenderBackend::Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+    const TextureFilter texture_filter, cv::Mat &warped_image) {
+
+    MORPH_PROFILE_SCOPE(ProfileStage::DRAW);
+
+    // Pixels outside of the mesh stay black
+    warped_image.create(source_image.size(), source_image.type());
+    warped_image.setTo(cv::Scalar::all(0));
+
+    const int triangle_count = grid_mesh.indices_.size() / 3;
+
+    MORPH_PROFILE_COUNT(ProfileCounter::DRAWN_TRIANGLES, triangle_count);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int triangle_index = 0; triangle_index < triangle_count; ++triangle_index) {
+      cv::Point2d positions[3];
+      cv::Point2d source_positions[3];
+
+      WarpedTrianglePositions(grid_mesh, warped_vertices, triangle_index, positions, source_positions);
+
+      RasterizeTriangle(source_image, warped_image, positions, source_positions, texture_filter);
+    }
+  }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "frame_arena.h"
+#include "render_backend.h"
+
+namespace ImageMorphing {
+
+  // Rasterizes the warped grid mesh on the CPU, needs no graphics context so it can run anywhere and on any thread.
+  // Trilinear and anisotropic filtering fall back to bilinear sampling.
+  class CPURenderBackend : public RenderBackend {
+
+  public:
+
+    cv::Mat Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+      const TextureFilter texture_filter) override;
+
+    void Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+      const TextureFilter texture_filter, cv::Mat &warped_image) override;
+
+  private:
+
+    // Warped images, usually released by the blend before the next frame
+    FrameArena frame_arena_;
+  };
+
+  // Corners of triangle triangle_index of grid_mesh in image coordinates (y axis pointing down), once warped and in the source image
+  void WarpedTrianglePositions(const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices, const size_t triangle_index,
+    cv::Point2d positions[3], cv::Point2d source_positions[3]);
+
+  // Draws one triangle of a warped mesh. Either image may be a region of a larger one, as long as
+  // positions are relative to warped_image and source_positions to source_image.
+  void RasterizeTriangle(const cv::Mat &source_image, cv::Mat &warped_image, cv::Point2d positions[3], cv::Point2d source_positions[3],
+    const TextureFilter texture_filter);
+
+}
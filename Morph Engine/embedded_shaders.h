@@ -0,0 +1,42 @@
+#pragma once
+
+// Sources of the shaders of GLRenderBackend, compiled into the executable so no shader file has to be shipped or kept in sync
+
+namespace ImageMorphing {
+
+  const char *const EMBEDDED_VERTEX_SHADER_SOURCE = R"glsl(#version 410
+
+attribute vec3 vertex_position;
+attribute vec3 vertex_color;
+attribute vec2 vertex_uv;
+
+uniform mat4 modelview_matrix;
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+varying vec3 fragment_color;
+varying vec2 fragment_vertex_uv;
+
+void main () {
+  fragment_color = vertex_color;
+  fragment_vertex_uv = vec2(vertex_uv.x, vertex_uv.y);
+
+  gl_Position = projection_matrix * view_matrix * modelview_matrix * vec4(vertex_position, 1.0);
+}
+)glsl";
+
+  const char *const EMBEDDED_FRAGMENT_SHADER_SOURCE = R"glsl(#version 410
+
+uniform sampler2D texture;
+
+uniform lowp float texture_flag;
+
+varying vec3 fragment_color;
+varying vec2 fragment_vertex_uv;
+
+void main () {
+  gl_FragColor = texture_flag * texture2D(texture, fragment_vertex_uv) + (1.0 - texture_flag) * vec4(fragment_color, 1.0);
+}
+)glsl";
+
+}
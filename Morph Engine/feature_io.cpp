@@ -0,0 +1,73 @@
+#include "feature_io.h"
+
+#include <fstream>
+
+#include "binary_feature_file.h"
+
+namespace ImageMorphing {
+
+  bool LoadFeatureLines(const std::string &file_path, std::vector<std::vector<FeatureLine> > &feature_lines_of_images) {
+    feature_lines_of_images.clear();
+
+    if (IsBinaryFeatureFile(file_path)) {
+      MappedFeatureFile feature_file;
+      if (!feature_file.Open(file_path)) {
+        return false;
+      }
+
+      for (const auto &feature_lines : feature_file.FeatureLinesOfImages()) {
+        feature_lines_of_images.push_back(std::vector<FeatureLine>(feature_lines.begin(), feature_lines.end()));
+      }
+
+      return true;
+    }
+
+    std::ifstream features_input_stream(file_path);
+    if (!features_input_stream) {
+      return false;
+    }
+
+    FeatureLine feature_line;
+
+    std::vector<FeatureLine> feature_lines;
+
+    while (features_input_stream >> feature_line.first.x >> feature_line.first.y >> feature_line.second.x >> feature_line.second.y) {
+      if (feature_line.first.x < 0) {
+        feature_lines_of_images.push_back(feature_lines);
+        feature_lines.clear();
+        continue;
+      }
+
+      feature_lines.push_back(feature_line);
+    }
+
+    // Files written by hand may miss the last separator
+    if (!feature_lines.empty()) {
+      feature_lines_of_images.push_back(feature_lines);
+    }
+
+    return true;
+  }
+
+  bool SaveFeatureLines(const std::string &file_path, const std::vector<std::vector<FeatureLine> > &feature_lines_of_images) {
+    if (file_path.size() >= BINARY_FEATURE_FILE_EXTENSION.size() &&
+      !file_path.compare(file_path.size() - BINARY_FEATURE_FILE_EXTENSION.size(), BINARY_FEATURE_FILE_EXTENSION.size(), BINARY_FEATURE_FILE_EXTENSION)) {
+      return SaveBinaryFeatureLines(file_path, std::vector<FeatureLineSpan>(feature_lines_of_images.begin(), feature_lines_of_images.end()));
+    }
+
+    std::ofstream features_output_stream(file_path);
+    if (!features_output_stream) {
+      return false;
+    }
+
+    for (const auto &feature_lines : feature_lines_of_images) {
+      for (const auto &feature_line : feature_lines) {
+        features_output_stream << feature_line.first.x << " " << feature_line.first.y << " " << feature_line.second.x << " " << feature_line.second.y << "\n";
+      }
+      features_output_stream << "-1 -1 -1 -1\n";
+    }
+
+    return (bool)features_output_stream;
+  }
+
+}
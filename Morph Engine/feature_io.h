@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "feature_line.h"
+
+namespace ImageMorphing {
+
+  // Text feature file: one line "x1 y1 x2 y2" per feature line, the lines of every image end with "-1 -1 -1 -1".
+  // Binary feature files are recognized by their magic and read as well.
+  bool LoadFeatureLines(const std::string &file_path, std::vector<std::vector<FeatureLine> > &feature_lines_of_images);
+
+  // Writes a binary feature file when the path ends with BINARY_FEATURE_FILE_EXTENSION, a text one otherwise
+  bool SaveFeatureLines(const std::string &file_path, const std::vector<std::vector<FeatureLine> > &feature_lines_of_images);
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cmath>
+
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  typedef std::pair<cv::Point2d, cv::Point2d> FeatureLine;
+
+  // Read-only view of contiguous feature lines, either a std::vector or memory owned by somebody else (e.g. a mapped file)
+  class FeatureLineSpan {
+
+  public:
+
+    FeatureLineSpan() : data_(nullptr), size_(0) {
+    }
+
+    FeatureLineSpan(const FeatureLine *data, const size_t size) : data_(data), size_(size) {
+    }
+
+    FeatureLineSpan(const std::vector<FeatureLine> &feature_lines) : data_(feature_lines.data()), size_(feature_lines.size()) {
+    }
+
+    const FeatureLine &operator [](const size_t index) const {
+      return data_[index];
+    }
+
+    size_t size() const {
+      return size_;
+    }
+
+    bool empty() const {
+      return !size_;
+    }
+
+    const FeatureLine *begin() const {
+      return data_;
+    }
+
+    const FeatureLine *end() const {
+      return data_ + size_;
+    }
+
+  private:
+
+    const FeatureLine *data_;
+    size_t size_;
+  };
+
+  inline double SqrLineLength(const FeatureLine &line) {
+    return std::pow(line.second.x - line.first.x, 2.0) + std::pow(line.second.y - line.first.y, 2.0);
+  }
+
+  inline double LineLength(const FeatureLine &line) {
+    return std::sqrt(SqrLineLength(line));
+  }
+
+  inline cv::Point2d LineMidpoint(const FeatureLine &line) {
+    return cv::Point2d((line.first.x + line.second.x) * 0.5, (line.first.y + line.second.y) * 0.5);
+  }
+
+  inline double LineOrientation(const FeatureLine &line) {
+    return std::atan2(line.second.y - line.first.y, line.second.x - line.first.x);
+  }
+
+  inline cv::Point2d Perpendicular(const cv::Point2d &v) {
+    return cv::Point2d(-v.y, v.x);
+  }
+
+  inline FeatureLine LineInterpolation(const FeatureLine &l1, const FeatureLine &l2, double t) {
+    //FeatureLine result_line(l1.first * (1 - t) + l2.first * t, l1.second * (1 - t) + l2.second * t);
+    //return result_line;
+
+    double new_line_length = LineLength(l1) * (1 - t) + LineLength(l2) * t;
+    cv::Point2d new_line_midpoint = LineMidpoint(l1) * (1 - t) + LineMidpoint(l2) * t;
+    double new_line_orientation = LineOrientation(l1) * (1 - t) + LineOrientation(l2) * t;
+
+    cv::Point2d new_line_direction = new_line_length * 0.5 * cv::Point2d(std::cos(new_line_orientation), std::sin(new_line_orientation));
+
+    FeatureLine result_line(new_line_midpoint - new_line_direction, new_line_midpoint + new_line_direction);
+
+    return result_line;
+  }
+
+  // Writes into feature_lines_at_t, whose capacity is kept when it is reused from frame to frame
+  inline void FeatureLinesInterpolation(const FeatureLineSpan &source_feature_lines, const FeatureLineSpan &destination_feature_lines, const double t,
+    std::vector<FeatureLine> &feature_lines_at_t) {
+    feature_lines_at_t.resize(source_feature_lines.size());
+
+    for (size_t i = 0; i < feature_lines_at_t.size(); ++i) {
+      feature_lines_at_t[i] = LineInterpolation(source_feature_lines[i], destination_feature_lines[i], t);
+    }
+  }
+
+  inline std::vector<FeatureLine> FeatureLinesInterpolation(const FeatureLineSpan &source_feature_lines, const FeatureLineSpan &destination_feature_lines, const double t) {
+    std::vector<FeatureLine> feature_lines_at_t;
+    FeatureLinesInterpolation(source_feature_lines, destination_feature_lines, t, feature_lines_at_t);
+    return feature_lines_at_t;
+  }
+
+  // Mirrors the lines vertically, between image coordinates (y axis points down) and OpenGL coordinates (y axis points up)
+  inline void FlipFeatureLines(const FeatureLineSpan &feature_lines, const int image_height, std::vector<FeatureLine> &flipped_feature_lines) {
+    flipped_feature_lines.assign(feature_lines.begin(), feature_lines.end());
+
+    for (auto &line : flipped_feature_lines) {
+      line.first.y = image_height - line.first.y;
+      line.second.y = image_height - line.second.y;
+    }
+  }
+
+  inline std::vector<FeatureLine> FlipFeatureLines(const FeatureLineSpan &feature_lines, const int image_height) {
+    std::vector<FeatureLine> flipped_feature_lines;
+    FlipFeatureLines(feature_lines, image_height, flipped_feature_lines);
+    return flipped_feature_lines;
+  }
+
+  // Lines drawn on an image of image_size, moved onto the same image resampled to resampled_size.
+  // Pixel centers map onto pixel centers, as in cv::resize.
+  inline std::vector<FeatureLine> ResampleFeatureLines(const FeatureLineSpan &feature_lines, const cv::Size &image_size, const cv::Size &resampled_size) {
+    std::vector<FeatureLine> resampled_feature_lines(feature_lines.begin(), feature_lines.end());
+
+    if (image_size == resampled_size) {
+      return resampled_feature_lines;
+    }
+
+    const double scale_x = resampled_size.width / (double)image_size.width;
+    const double scale_y = resampled_size.height / (double)image_size.height;
+
+    for (auto &line : resampled_feature_lines) {
+      line.first.x = (line.first.x + 0.5) * scale_x - 0.5;
+      line.first.y = (line.first.y + 0.5) * scale_y - 0.5;
+      line.second.x = (line.second.x + 0.5) * scale_x - 0.5;
+      line.second.y = (line.second.y + 0.5) * scale_y - 0.5;
+    }
+
+    return resampled_feature_lines;
+  }
+
+}
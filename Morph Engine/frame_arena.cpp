@@ -0,0 +1,49 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    // Only the arena still references the buffer of image. The last other reference may have been released on another
+    // thread (e.g. the consumer of a FramePipeline), the count is read with the same atomic OpenCV decrements it with,
+    // so everything that thread did with the buffer happens before it is handed out again.
+    bool IsImageFree(const cv::Mat &image) {
+      return image.u && CV_XADD(&image.u->refcount, 0) == 1;
+    }
+
+  }
+
+  FrameArena::FrameArena() : allocation_count_(0) {
+  }
+
+  cv::Mat FrameArena::Image(const cv::Size &size, const int type) {
+    for (const auto &image : images_) {
+      if (image.size() == size && image.type() == type && IsImageFree(image)) {
+        return image;
+      }
+    }
+
+    // Free buffers of another size or type would only be reused if the frame size changes back, drop them first
+    Trim();
+
+    images_.push_back(cv::Mat(size, type));
+    ++allocation_count_;
+
+    return images_.back();
+  }
+
+  cv::Mat FrameArena::Zeros(const cv::Size &size, const int type) {
+    cv::Mat image = Image(size, type);
+    image.setTo(cv::Scalar::all(0));
+    return image;
+  }
+
+  void FrameArena::Trim() {
+    images_.erase(std::remove_if(images_.begin(), images_.end(), [](const cv::Mat &image) {
+      return IsImageFree(image);
+    }), images_.end());
+  }
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  // Image buffers reused from frame to frame by one worker. A buffer is handed out again once every cv::Mat
+  // referencing it was released, so images returned to callers keep their content for as long as they are held,
+  // and a worker morphing frames of one size stops allocating after the first few frames.
+  // Not thread safe, every worker (engine, backend) has its own.
+  class FrameArena {
+
+  public:
+
+    FrameArena();
+
+    // Image of size and type with undefined content
+    cv::Mat Image(const cv::Size &size, const int type);
+
+    cv::Mat Zeros(const cv::Size &size, const int type);
+
+    // Drops every buffer nobody references anymore
+    void Trim();
+
+    // Buffers allocated since construction, stays the same from frame to frame in steady state
+    size_t allocation_count_;
+
+  private:
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator =(const FrameArena &) = delete;
+
+    std::vector<cv::Mat> images_;
+  };
+
+}
@@ -0,0 +1,157 @@
+#include "frame_pipeline.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    struct PipelineState {
+
+      explicit PipelineState(const size_t max_jobs_in_flight) : next_job_index_(0), next_consumed_job_index_(0),
+        job_slots_(max_jobs_in_flight), is_job_produced_(max_jobs_in_flight, false) {
+      }
+
+      std::mutex mutex_;
+
+      // Signaled when the consumer is done with a job, so a worker may claim another one
+      std::condition_variable job_consumed_;
+
+      // Signaled when a worker finished a job
+      std::condition_variable job_produced_;
+
+      size_t next_job_index_;
+      size_t next_consumed_job_index_;
+
+      // First exception thrown by a worker or the consumer. Once set no job is claimed or consumed anymore.
+      std::exception_ptr error_;
+
+      // Reorder buffer, job j owns slot j % max_jobs_in_flight. A job is only claimed once the one that used its slot before
+      // was consumed, so a slot is only touched by the worker producing into it, then by the consumer, without the lock.
+      std::vector<std::vector<cv::Mat> > job_slots_;
+      std::vector<bool> is_job_produced_;
+    };
+
+    // Records the exception being handled and wakes every thread so they stop
+    void Fail(PipelineState &state) {
+      {
+        std::lock_guard<std::mutex> lock(state.mutex_);
+        if (!state.error_) {
+          state.error_ = std::current_exception();
+        }
+      }
+      state.job_consumed_.notify_all();
+      state.job_produced_.notify_all();
+    }
+
+    void WorkerLoop(PipelineState &state, const size_t job_count, const size_t max_jobs_in_flight, const size_t worker_index,
+      const FramePipeline::ProduceFunction &produce) {
+      try {
+        for (;;) {
+          size_t job_index;
+
+          {
+            std::unique_lock<std::mutex> lock(state.mutex_);
+            state.job_consumed_.wait(lock, [&] {
+              return state.error_ || state.next_job_index_ >= job_count || state.next_job_index_ < state.next_consumed_job_index_ + max_jobs_in_flight;
+            });
+
+            if (state.error_ || state.next_job_index_ >= job_count) {
+              return;
+            }
+
+            job_index = state.next_job_index_++;
+          }
+
+          const size_t slot_index = job_index % max_jobs_in_flight;
+          produce(job_index, worker_index, state.job_slots_[slot_index]);
+
+          {
+            std::lock_guard<std::mutex> lock(state.mutex_);
+            state.is_job_produced_[slot_index] = true;
+          }
+          state.job_produced_.notify_one();
+        }
+      } catch (...) {
+        Fail(state);
+      }
+    }
+
+    void ConsumerLoop(PipelineState &state, const size_t job_count, const size_t max_jobs_in_flight, const FramePipeline::ConsumeFunction &consume) {
+      try {
+        for (size_t job_index = 0; job_index < job_count; ++job_index) {
+          const size_t slot_index = job_index % max_jobs_in_flight;
+
+          {
+            std::unique_lock<std::mutex> lock(state.mutex_);
+            state.job_produced_.wait(lock, [&] {
+              return state.error_ || state.is_job_produced_[slot_index];
+            });
+
+            if (state.error_) {
+              return;
+            }
+          }
+
+          std::vector<cv::Mat> &frames = state.job_slots_[slot_index];
+
+          for (const auto &frame : frames) {
+            consume(frame);
+          }
+
+          // Releases the frames, the slot keeps its capacity for the next job
+          frames.clear();
+
+          {
+            std::lock_guard<std::mutex> lock(state.mutex_);
+            state.is_job_produced_[slot_index] = false;
+            state.next_consumed_job_index_ = job_index + 1;
+          }
+          state.job_consumed_.notify_all();
+        }
+      } catch (...) {
+        Fail(state);
+      }
+    }
+
+  }
+
+  FramePipeline::FramePipeline(const size_t worker_count, const size_t max_jobs_in_flight) : worker_count_(worker_count), max_jobs_in_flight_(max_jobs_in_flight) {
+  }
+
+  void FramePipeline::Run(const size_t job_count, const ProduceFunction &produce, const ConsumeFunction &consume) const {
+    const size_t worker_count = std::max<size_t>(1, worker_count_);
+    const size_t max_jobs_in_flight = max_jobs_in_flight_ ? max_jobs_in_flight_ : worker_count * PIPELINE_JOBS_IN_FLIGHT_PER_WORKER;
+
+    PipelineState state(max_jobs_in_flight);
+
+    std::thread consumer_thread(ConsumerLoop, std::ref(state), job_count, max_jobs_in_flight, std::cref(consume));
+
+    std::vector<std::thread> worker_threads;
+    try {
+      for (size_t worker_index = 1; worker_index < worker_count; ++worker_index) {
+        worker_threads.push_back(std::thread(WorkerLoop, std::ref(state), job_count, max_jobs_in_flight, worker_index, std::cref(produce)));
+      }
+    } catch (...) {
+      // Not every worker could be started, the ones that were stop with the consumer
+      Fail(state);
+    }
+
+    WorkerLoop(state, job_count, max_jobs_in_flight, 0, produce);
+
+    for (auto &worker_thread : worker_threads) {
+      worker_thread.join();
+    }
+
+    consumer_thread.join();
+
+    if (state.error_) {
+      std::rethrow_exception(state.error_);
+    }
+  }
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  // Jobs a worker may have produced or be producing before the consumer catches up
+  const size_t PIPELINE_JOBS_IN_FLIGHT_PER_WORKER = 2;
+
+  // Bounded producer/consumer pipeline. Jobs are produced out of order by the workers and handed to the consumer
+  // in job order through a reorder buffer of max_jobs_in_flight_ slots, allocated once per Run. A worker only claims a new job while fewer than max_jobs_in_flight_ jobs
+  // are waiting for or going through the consumer, which bounds the number of frames held in memory.
+  // The calling thread is worker 0, so a produce function bound to a GL context stays on the context thread.
+  // The consumer always runs on its own thread.
+  class FramePipeline {
+
+  public:
+
+    // Appends the frames of one job to frames, worker_index tells which of the worker_count_ workers is calling.
+    // frames starts empty, it is a slot of the pipeline that keeps its capacity from job to job.
+    typedef std::function<void(const size_t job_index, const size_t worker_index, std::vector<cv::Mat> &frames)> ProduceFunction;
+
+    typedef std::function<void(const cv::Mat &frame)> ConsumeFunction;
+
+    // A max_jobs_in_flight of 0 allows PIPELINE_JOBS_IN_FLIGHT_PER_WORKER jobs per worker
+    explicit FramePipeline(const size_t worker_count = 1, const size_t max_jobs_in_flight = 0);
+
+    // When produce or consume throws, no further job is started, every thread is joined and Run rethrows the first exception
+    void Run(const size_t job_count, const ProduceFunction &produce, const ConsumeFunction &consume) const;
+
+    size_t worker_count_;
+    size_t max_jobs_in_flight_;
+  };
+
+}
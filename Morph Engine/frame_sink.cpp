@@ -0,0 +1,305 @@
+#include "frame_sink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "pixel_format.h"
+#include "profiler.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace ImageMorphing {
+
+  namespace {
+
+    // Whether path_pattern holds exactly one printf integer conversion with optional flags and width, e.g. "%05d".
+    // "%%" stands for a literal percent sign, any other conversion would read arguments that are never passed.
+    bool IsFramePathPattern(const std::string &path_pattern) {
+      size_t conversion_count = 0;
+
+      for (size_t i = 0; i < path_pattern.size(); ++i) {
+        if (path_pattern[i] != '%') {
+          continue;
+        }
+
+        if (++i < path_pattern.size() && path_pattern[i] == '%') {
+          continue;
+        }
+
+        while (i < path_pattern.size() && strchr("-+ #0", path_pattern[i])) {
+          ++i;
+        }
+
+        while (i < path_pattern.size() && isdigit((unsigned char)path_pattern[i])) {
+          ++i;
+        }
+
+        if (i == path_pattern.size() || !strchr("diu", path_pattern[i])) {
+          return false;
+        }
+
+        ++conversion_count;
+      }
+
+      return conversion_count == 1;
+    }
+
+  }
+
+  VideoFrameSink::VideoFrameSink(const std::string &file_path, const std::string &fourcc, const double fps) : file_path_(file_path), fourcc_(fourcc), fps_(fps) {
+  }
+
+  bool VideoFrameSink::Open(const cv::Size &frame_size) {
+    if (fourcc_.size() != 4) {
+      return false;
+    }
+
+    return video_writer_.open(file_path_, cv::VideoWriter::fourcc(fourcc_[0], fourcc_[1], fourcc_[2], fourcc_[3]), fps_, frame_size);
+  }
+
+  bool VideoFrameSink::Write(const cv::Mat &frame) {
+    MORPH_PROFILE_SCOPE(ProfileStage::ENCODE);
+    MORPH_PROFILE_COUNT(ProfileCounter::ENCODED_FRAMES, 1);
+
+    // Video codecs take 8-bit BGR, BGRA frames are shown over black
+    video_writer_.write(To8BitBGR(frame));
+    return true;
+  }
+
+  bool VideoFrameSink::Close() {
+    video_writer_.release();
+    return true;
+  }
+
+  struct ImageSequenceFrameSink::EncoderPool {
+
+    EncoderPool(const size_t max_pending_frames) : max_pending_frames_(max_pending_frames), is_closing_(false), has_failed_(false) {
+    }
+
+    const size_t max_pending_frames_;
+
+    std::mutex mutex_;
+
+    // Signaled when a frame was queued or the pool closes
+    std::condition_variable frame_queued_;
+
+    // Signaled when an encoder took a frame off the queue
+    std::condition_variable frame_taken_;
+
+    std::deque<std::pair<std::string, cv::Mat> > pending_frames_;
+    bool is_closing_;
+
+    std::atomic<bool> has_failed_;
+
+    std::vector<std::thread> encoder_threads_;
+  };
+
+  ImageSequenceFrameSink::ImageSequenceFrameSink(const std::string &path_pattern, const size_t encoder_thread_count, const size_t max_pending_frames)
+    : jpeg_quality_(DEFAULT_JPEG_QUALITY), png_compression_(DEFAULT_PNG_COMPRESSION), path_pattern_(path_pattern),
+    encoder_thread_count_(encoder_thread_count), max_pending_frames_(max_pending_frames), frame_count_(0) {
+  }
+
+  ImageSequenceFrameSink::~ImageSequenceFrameSink() {
+    Close();
+  }
+
+  std::string ImageSequenceFrameSink::FramePath(const size_t frame_index) const {
+    // The pattern was checked by Open to hold a single integer conversion, so it is safe to use as the format
+    const int path_length = snprintf(nullptr, 0, path_pattern_.c_str(), (int)frame_index);
+    std::vector<char> frame_path(std::max(path_length, 0) + 1);
+    snprintf(frame_path.data(), frame_path.size(), path_pattern_.c_str(), (int)frame_index);
+    return frame_path.data();
+  }
+
+  bool ImageSequenceFrameSink::Open(const cv::Size &) {
+    Close();
+
+    if (!IsFramePathPattern(path_pattern_)) {
+      return false;
+    }
+
+    const size_t encoder_thread_count = encoder_thread_count_ ? encoder_thread_count_ : std::max<unsigned int>(1, std::thread::hardware_concurrency());
+    const size_t max_pending_frames = max_pending_frames_ ? max_pending_frames_ : encoder_thread_count * 2;
+
+    std::vector<int> encode_parameters;
+    encode_parameters.push_back(cv::IMWRITE_JPEG_QUALITY);
+    encode_parameters.push_back(jpeg_quality_);
+    encode_parameters.push_back(cv::IMWRITE_PNG_COMPRESSION);
+    encode_parameters.push_back(png_compression_);
+
+    encoder_pool_.reset(new EncoderPool(max_pending_frames));
+    frame_count_ = 0;
+
+    EncoderPool &encoder_pool = *encoder_pool_;
+
+    for (size_t i = 0; i < encoder_thread_count; ++i) {
+      encoder_pool.encoder_threads_.push_back(std::thread([&encoder_pool, encode_parameters] {
+        for (;;) {
+          std::pair<std::string, cv::Mat> pending_frame;
+
+          {
+            std::unique_lock<std::mutex> lock(encoder_pool.mutex_);
+            encoder_pool.frame_queued_.wait(lock, [&] {
+              return !encoder_pool.pending_frames_.empty() || encoder_pool.is_closing_;
+            });
+
+            if (encoder_pool.pending_frames_.empty()) {
+              return;
+            }
+
+            pending_frame = std::move(encoder_pool.pending_frames_.front());
+            encoder_pool.pending_frames_.pop_front();
+          }
+          encoder_pool.frame_taken_.notify_one();
+
+          // Encoder threads are not tied to a frame, their events show up under frame -1 and their own thread in traces
+          MORPH_PROFILE_SCOPE(ProfileStage::ENCODE);
+          MORPH_PROFILE_COUNT(ProfileCounter::ENCODED_FRAMES, 1);
+
+          if (!WriteImage(pending_frame.first, pending_frame.second, encode_parameters)) {
+            encoder_pool.has_failed_ = true;
+          }
+        }
+      }));
+    }
+
+    return true;
+  }
+
+  bool ImageSequenceFrameSink::Write(const cv::Mat &frame) {
+    if (!encoder_pool_) {
+      return false;
+    }
+
+    EncoderPool &encoder_pool = *encoder_pool_;
+
+    std::pair<std::string, cv::Mat> pending_frame(FramePath(frame_count_++), frame);
+
+    {
+      std::unique_lock<std::mutex> lock(encoder_pool.mutex_);
+      encoder_pool.frame_taken_.wait(lock, [&] {
+        return encoder_pool.pending_frames_.size() < encoder_pool.max_pending_frames_;
+      });
+
+      encoder_pool.pending_frames_.push_back(std::move(pending_frame));
+    }
+    encoder_pool.frame_queued_.notify_one();
+
+    return !encoder_pool.has_failed_;
+  }
+
+  bool ImageSequenceFrameSink::Close() {
+    if (!encoder_pool_) {
+      return true;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(encoder_pool_->mutex_);
+      encoder_pool_->is_closing_ = true;
+    }
+    encoder_pool_->frame_queued_.notify_all();
+
+    for (auto &encoder_thread : encoder_pool_->encoder_threads_) {
+      encoder_thread.join();
+    }
+
+    bool has_failed = encoder_pool_->has_failed_;
+    encoder_pool_.reset();
+
+    return !has_failed;
+  }
+
+  RawFrameSink::RawFrameSink(const std::string &file_path) : file_path_(file_path), file_(nullptr), is_good_(false) {
+  }
+
+  RawFrameSink::~RawFrameSink() {
+    Close();
+  }
+
+  bool RawFrameSink::Open(const cv::Size &) {
+    Close();
+
+    if (file_path_ == STDOUT_OUTPUT) {
+#ifdef _WIN32
+      // Keep the C runtime from turning "\n" bytes into "\r\n"
+      _setmode(_fileno(stdout), _O_BINARY);
+#endif
+      file_ = stdout;
+    } else {
+      file_ = fopen(file_path_.c_str(), "wb");
+    }
+
+    is_good_ = file_ != nullptr;
+    return is_good_;
+  }
+
+  bool RawFrameSink::Write(const cv::Mat &frame) {
+    if (!file_ || !IsSupportedImageType(frame.type())) {
+      return false;
+    }
+
+    MORPH_PROFILE_SCOPE(ProfileStage::ENCODE);
+    MORPH_PROFILE_COUNT(ProfileCounter::ENCODED_FRAMES, 1);
+
+    // Raw video readers expect straight alpha
+    const cv::Mat straight_frame = UnpremultiplyAlpha(frame);
+
+    // Frames may be views into a larger image, so rows are written one by one unless they are contiguous
+    if (straight_frame.isContinuous()) {
+      is_good_ = is_good_ && fwrite(straight_frame.data, straight_frame.elemSize(), straight_frame.total(), file_) == straight_frame.total();
+    } else {
+      for (int r = 0; r < straight_frame.rows && is_good_; ++r) {
+        is_good_ = fwrite(straight_frame.ptr(r), straight_frame.elemSize(), straight_frame.cols, file_) == (size_t)straight_frame.cols;
+      }
+    }
+
+    return is_good_;
+  }
+
+  bool RawFrameSink::Close() {
+    if (!file_) {
+      return true;
+    }
+
+    is_good_ = !fflush(file_) && is_good_;
+
+    if (file_ != stdout) {
+      is_good_ = !fclose(file_) && is_good_;
+    }
+
+    file_ = nullptr;
+
+    return is_good_;
+  }
+
+  std::unique_ptr<FrameSink> CreateFrameSink(const std::string &output, const FrameSinkOptions &options) {
+    if (output == STDOUT_OUTPUT) {
+      return std::unique_ptr<FrameSink>(new RawFrameSink(STDOUT_OUTPUT));
+    }
+
+    if (!output.compare(0, RAW_OUTPUT_PREFIX.size(), RAW_OUTPUT_PREFIX)) {
+      return std::unique_ptr<FrameSink>(new RawFrameSink(output.substr(RAW_OUTPUT_PREFIX.size())));
+    }
+
+    if (output.find('%') != std::string::npos) {
+      return std::unique_ptr<FrameSink>(new ImageSequenceFrameSink(output, options.encoder_thread_count_));
+    }
+
+    return std::unique_ptr<FrameSink>(new VideoFrameSink(output, options.fourcc_, options.fps_));
+  }
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+namespace ImageMorphing {
+
+  const std::string DEFAULT_VIDEO_FOURCC = "DIVX";
+  const double DEFAULT_VIDEO_FPS = 30;
+
+  const int DEFAULT_JPEG_QUALITY = 95;
+  const int DEFAULT_PNG_COMPRESSION = 3;
+
+  // Output of "-" writes raw frames to stdout
+  const std::string STDOUT_OUTPUT = "-";
+
+  // Outputs starting with "raw:" write raw frames to the file or named pipe after the prefix
+  const std::string RAW_OUTPUT_PREFIX = "raw:";
+
+  // Destination of the frames of a morph sequence, written in order
+  class FrameSink {
+
+  public:
+
+    virtual ~FrameSink() {
+    }
+
+    virtual bool Open(const cv::Size &frame_size) = 0;
+
+    virtual bool Write(const cv::Mat &frame) = 0;
+
+    // Flushes everything still pending, returns false if any frame could not be written
+    virtual bool Close() = 0;
+  };
+
+  // Encodes a video through cv::VideoWriter
+  class VideoFrameSink : public FrameSink {
+
+  public:
+
+    VideoFrameSink(const std::string &file_path, const std::string &fourcc = DEFAULT_VIDEO_FOURCC, const double fps = DEFAULT_VIDEO_FPS);
+
+    bool Open(const cv::Size &frame_size) override;
+
+    bool Write(const cv::Mat &frame) override;
+
+    bool Close() override;
+
+  private:
+
+    std::string file_path_;
+    std::string fourcc_;
+    double fps_;
+
+    cv::VideoWriter video_writer_;
+  };
+
+  // Writes every frame as its own image, the format follows the extension. Frames are encoded by a pool of threads,
+  // Write only blocks when max_pending_frames frames are already waiting for an encoder.
+  class ImageSequenceFrameSink : public FrameSink {
+
+  public:
+
+    // path_pattern holds one printf integer conversion for the frame number, e.g. "frames/%05d.png", and "%%" for a literal percent sign.
+    // An encoder_thread_count of 0 uses every hardware thread.
+    ImageSequenceFrameSink(const std::string &path_pattern, const size_t encoder_thread_count = 0, const size_t max_pending_frames = 0);
+
+    ~ImageSequenceFrameSink();
+
+    bool Open(const cv::Size &frame_size) override;
+
+    bool Write(const cv::Mat &frame) override;
+
+    bool Close() override;
+
+    int jpeg_quality_;
+    int png_compression_;
+
+  private:
+
+    ImageSequenceFrameSink(const ImageSequenceFrameSink &) = delete;
+    ImageSequenceFrameSink &operator =(const ImageSequenceFrameSink &) = delete;
+
+    std::string FramePath(const size_t frame_index) const;
+
+    // Keeps <thread> and <mutex> out of the header, which code compiled with /clr cannot include
+    struct EncoderPool;
+
+    std::unique_ptr<EncoderPool> encoder_pool_;
+
+    std::string path_pattern_;
+    size_t encoder_thread_count_;
+    size_t max_pending_frames_;
+
+    size_t frame_count_;
+  };
+
+  // Writes the frames as packed 8-bit BGR rows with no header, e.g. for ffmpeg -f rawvideo -pix_fmt bgr24,
+  // BGRA rows with straight alpha for -pix_fmt bgra, 16-bit BGR rows in host byte order for -pix_fmt bgr48le,
+  // or rows of float BGR triplets
+  class RawFrameSink : public FrameSink {
+
+  public:
+
+    // STDOUT_OUTPUT writes to stdout, any other path is opened as a file or an existing named pipe
+    explicit RawFrameSink(const std::string &file_path);
+
+    ~RawFrameSink();
+
+    bool Open(const cv::Size &frame_size) override;
+
+    bool Write(const cv::Mat &frame) override;
+
+    bool Close() override;
+
+  private:
+
+    RawFrameSink(const RawFrameSink &) = delete;
+    RawFrameSink &operator =(const RawFrameSink &) = delete;
+
+    std::string file_path_;
+
+    FILE *file_;
+    bool is_good_;
+  };
+
+  struct FrameSinkOptions {
+
+    FrameSinkOptions() : fourcc_(DEFAULT_VIDEO_FOURCC), fps_(DEFAULT_VIDEO_FPS), encoder_thread_count_(0) {
+    }
+
+    std::string fourcc_;
+    double fps_;
+
+    size_t encoder_thread_count_;
+  };
+
+  // Picks the sink from the output: STDOUT_OUTPUT or RAW_OUTPUT_PREFIX for raw frames,
+  // a path with a '%' for an image sequence, anything else for a video
+  std::unique_ptr<FrameSink> CreateFrameSink(const std::string &output, const FrameSinkOptions &options);
+
+}
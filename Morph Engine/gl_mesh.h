@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "gl_shader.h"
+
+namespace ImageMorphing {
+
+  // Per-vertex attributes which do not change once the mesh is built, stored interleaved in one buffer
+  struct GLVertexAttributes {
+
+    GLVertexAttributes() : color_(0.0f), uv_(0.0f) {
+    }
+
+    GLVertexAttributes(const glm::vec3 &color, const glm::vec2 &uv) : color_(color), uv_(uv) {
+    }
+
+    glm::vec3 color_;
+    glm::vec2 uv_;
+  };
+
+  // Positions live in their own buffer so moving the vertices between frames only touches that buffer,
+  // colors and uvs are interleaved in a static buffer, and faces are drawn through an index buffer
+  class GLMesh {
+
+  public:
+
+    GLMesh() : vertices_type(GL_TRIANGLES), texture_id_(0), texture_flag_(false), vao_(0), vbo_vertices_(0), vbo_attributes_(0), ibo_indices_(0), uploaded_vertices_count_(0), uploaded_indices_count_(0), local_modelview_matrix_(glm::mat4(1.0)) {
+    }
+
+    void Translate(const glm::vec3 &translation_vector) {
+      local_modelview_matrix_ = glm::translate(local_modelview_matrix_, translation_vector);
+    }
+
+    void Upload(const GLShaderProgram &shader_program) {
+      if (!vao_) {
+        glGenVertexArrays(1, &vao_);
+      }
+
+      glBindVertexArray(vao_);
+
+      if (vertices_.size()) {
+        if (!vbo_vertices_) {
+          glGenBuffers(1, &vbo_vertices_);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
+        glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(vertices_[0]), vertices_.data(), GL_DYNAMIC_DRAW);
+
+        if (shader_program.attribute_vertex_position_id_ >= 0) {
+          glEnableVertexAttribArray(shader_program.attribute_vertex_position_id_);
+          glVertexAttribPointer(shader_program.attribute_vertex_position_id_, 3, GL_FLOAT, GL_FALSE, sizeof(vertices_[0]), 0);
+        }
+      }
+
+      if (attributes_.size()) {
+        if (!vbo_attributes_) {
+          glGenBuffers(1, &vbo_attributes_);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_attributes_);
+        glBufferData(GL_ARRAY_BUFFER, attributes_.size() * sizeof(attributes_[0]), attributes_.data(), GL_STATIC_DRAW);
+
+        if (shader_program.attribute_vertex_color_id_ >= 0) {
+          glEnableVertexAttribArray(shader_program.attribute_vertex_color_id_);
+          glVertexAttribPointer(shader_program.attribute_vertex_color_id_, 3, GL_FLOAT, GL_FALSE, sizeof(attributes_[0]), (const GLvoid *)offsetof(GLVertexAttributes, color_));
+        }
+
+        if (shader_program.attribute_vertex_uv_id_ >= 0) {
+          glEnableVertexAttribArray(shader_program.attribute_vertex_uv_id_);
+          glVertexAttribPointer(shader_program.attribute_vertex_uv_id_, 2, GL_FLOAT, GL_FALSE, sizeof(attributes_[0]), (const GLvoid *)offsetof(GLVertexAttributes, uv_));
+        }
+      }
+
+      if (indices_.size()) {
+        if (!ibo_indices_) {
+          glGenBuffers(1, &ibo_indices_);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_indices_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(indices_[0]), indices_.data(), GL_STATIC_DRAW);
+      }
+
+      glBindVertexArray(0);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+      uploaded_vertices_count_ = vertices_.size();
+      uploaded_indices_count_ = indices_.size();
+    }
+
+    // Re-upload vertices_[first, first + count) in place, the rest of the mesh must already be uploaded
+    void UpdateVertices(const GLShaderProgram &shader_program, size_t first, size_t count) {
+      if (!vbo_vertices_ || vertices_.size() != uploaded_vertices_count_) {
+        Upload(shader_program);
+        return;
+      }
+
+      if (first >= vertices_.size()) {
+        return;
+      }
+
+      count = std::min(count, vertices_.size() - first);
+
+      glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
+      glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(vertices_[0]), count * sizeof(vertices_[0]), &vertices_[first]);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void UpdateVertices(const GLShaderProgram &shader_program) {
+      UpdateVertices(shader_program, 0, vertices_.size());
+    }
+
+    void Release() {
+      if (ibo_indices_) {
+        glDeleteBuffers(1, &ibo_indices_);
+      }
+
+      if (vbo_attributes_) {
+        glDeleteBuffers(1, &vbo_attributes_);
+      }
+
+      if (vbo_vertices_) {
+        glDeleteBuffers(1, &vbo_vertices_);
+      }
+
+      if (vao_) {
+        glDeleteVertexArrays(1, &vao_);
+      }
+
+      vao_ = vbo_vertices_ = vbo_attributes_ = ibo_indices_ = 0;
+      uploaded_vertices_count_ = uploaded_indices_count_ = 0;
+    }
+
+    void Clear() {
+      Release();
+
+      vertices_.clear();
+      attributes_.clear();
+      indices_.clear();
+      local_modelview_matrix_ = glm::mat4(1.0);
+      texture_id_ = 0;
+      texture_flag_ = false;
+    }
+
+    void Draw(const GLShaderProgram &shader_program) {
+      Draw(shader_program, glm::mat4(1.0f));
+    }
+
+    void Draw(const GLShaderProgram &shader_program, const glm::mat4 &parent_modelview_matrix) {
+      if (!vao_) {
+        return;
+      }
+
+      PrepareDraw(shader_program, parent_modelview_matrix);
+
+      if (ibo_indices_) {
+        glDrawElements(vertices_type, uploaded_indices_count_, GL_UNSIGNED_INT, 0);
+      } else {
+        glDrawArrays(vertices_type, 0, uploaded_vertices_count_);
+      }
+
+      glBindVertexArray(0);
+    }
+
+    // Draws the index buffer mesh_count times with one call, the i-th mesh using the vertices starting at i * vertices_per_mesh
+    void DrawBatch(const GLShaderProgram &shader_program, const glm::mat4 &parent_modelview_matrix, const size_t mesh_count, const size_t vertices_per_mesh) {
+      if (!vao_ || !ibo_indices_ || !mesh_count) {
+        return;
+      }
+
+      PrepareDraw(shader_program, parent_modelview_matrix);
+
+      // Kept with their capacity, so drawing batches of the same size every frame allocates nothing
+      batch_index_counts_.assign(mesh_count, uploaded_indices_count_);
+      batch_index_offsets_.assign(mesh_count, 0);
+      batch_base_vertices_.resize(mesh_count);
+
+      for (size_t i = 0; i < mesh_count; ++i) {
+        batch_base_vertices_[i] = i * vertices_per_mesh;
+      }
+
+      glMultiDrawElementsBaseVertex(vertices_type, batch_index_counts_.data(), GL_UNSIGNED_INT, batch_index_offsets_.data(), mesh_count, batch_base_vertices_.data());
+
+      glBindVertexArray(0);
+    }
+
+    std::vector<glm::vec3> vertices_;
+    std::vector<GLVertexAttributes> attributes_;
+    std::vector<GLuint> indices_;
+
+    GLuint vertices_type;
+
+    GLuint texture_id_;
+    bool texture_flag_;
+
+  private:
+
+    void PrepareDraw(const GLShaderProgram &shader_program, const glm::mat4 &parent_modelview_matrix) {
+      if (texture_flag_) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        glUniform1i(shader_program.uniform_texture_id_, 0);
+      }
+
+      glUniform1f(shader_program.uniform_texture_flag_id_, texture_flag_ ? 1.0 : 0.0);
+
+      glm::mat4 modelview_matrix = parent_modelview_matrix * local_modelview_matrix_;
+
+      glUniformMatrix4fv(shader_program.uniform_modelview_matrix_id_, 1, GL_FALSE, glm::value_ptr(modelview_matrix));
+
+      glBindVertexArray(vao_);
+    }
+
+    GLuint vao_;
+    GLuint vbo_vertices_;
+    GLuint vbo_attributes_;
+    GLuint ibo_indices_;
+
+    size_t uploaded_vertices_count_;
+    size_t uploaded_indices_count_;
+
+    std::vector<GLsizei> batch_index_counts_;
+    std::vector<const GLvoid *> batch_index_offsets_;
+    std::vector<GLint> batch_base_vertices_;
+
+    glm::mat4 local_modelview_matrix_;
+  };
+
+}
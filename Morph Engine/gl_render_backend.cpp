@@ -0,0 +1,399 @@
+#include "gl_render_backend.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "gl_texture.h"
+#include "profiler.h"
+
+namespace ImageMorphing {
+
+  const float FOVY = 45.0f;
+
+  const bool DRAW_MESH = false;
+
+  namespace {
+
+    // Frame buffer and read back layout of warped images of image_type.
+    // 16-bit and float RGB are not required to be renderable, their frame buffers get an unused alpha channel.
+    GLint RenderedFormat(const int image_type) {
+      switch (CV_MAT_DEPTH(image_type)) {
+      case CV_16U:
+        return GL_RGBA16;
+      case CV_32F:
+        return GL_RGBA32F;
+      default:
+        return CV_MAT_CN(image_type) == 4 ? GL_RGBA : GL_RGB;
+      }
+    }
+
+    GLenum ReadBackFormat(const int image_type) {
+      return CV_MAT_CN(image_type) == 4 ? GL_BGRA : GL_BGR;
+    }
+
+    GLenum ReadBackDataType(const int image_type) {
+      return GLTexture::PixelDataType(CV_MAT_DEPTH(image_type));
+    }
+
+    // Premultiplied texels must replace the cleared transparent black, not be blended over it a second time
+    class BlendingDisabledScope {
+
+    public:
+
+      BlendingDisabledScope() : was_blending_(glIsEnabled(GL_BLEND) == GL_TRUE) {
+        glDisable(GL_BLEND);
+      }
+
+      ~BlendingDisabledScope() {
+        if (was_blending_) {
+          glEnable(GL_BLEND);
+        }
+      }
+
+    private:
+
+      bool was_blending_;
+    };
+
+    // Lines of the mesh drawn over the warped image when DRAW_MESH is set. Textured draws ignore the color.
+    const glm::vec3 MESH_LINE_COLOR(1.0f, 0.0f, 0.0f);
+
+    // Source textures keep the top row of the image first, the uvs of the grid count v from the bottom
+    GLVertexAttributes TextureVertexAttributes(const glm::vec2 &uv) {
+      return GLVertexAttributes(MESH_LINE_COLOR, glm::vec2(uv.x, 1.0f - uv.y));
+    }
+
+  }
+
+  GLRenderBackend::GLRenderBackend() : atlas_mesh_cell_count_(0), source_texture_id_(0), source_texture_type_(-1), source_texture_filter_(TextureFilter::NEAREST) {
+  }
+
+  GLRenderBackend::~GLRenderBackend() {
+    gl_mesh_.Release();
+    atlas_mesh_.Release();
+    ReleaseRenderTarget(frame_render_target_);
+    ReleaseRenderTarget(atlas_render_target_);
+    glDeleteTextures(1, &source_texture_id_);
+    shader_program_.Release();
+  }
+
+  bool GLRenderBackend::Initialize(const std::string &vertex_shader_source, const std::string &fragment_shader_source, const std::string &shader_cache_directory, std::string &info_log) {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    return shader_program_.Load(vertex_shader_source, fragment_shader_source, shader_cache_directory, info_log);
+  }
+
+  void GLRenderBackend::UploadSourceTexture(const cv::Mat &source_image, const TextureFilter texture_filter) {
+    MORPH_PROFILE_SCOPE(ProfileStage::TEXTURE_UPLOAD);
+    MORPH_PROFILE_COUNT(ProfileCounter::UPLOADED_BYTES, source_image.total() * source_image.elemSize());
+
+    if (source_texture_id_ && source_texture_size_ == source_image.size() && source_texture_type_ == source_image.type() && source_texture_filter_ == texture_filter) {
+      GLTexture::UpdateGLTexture(source_image, source_texture_id_, texture_filter);
+      return;
+    }
+
+    GLTexture::SetGLTexture(source_image, &source_texture_id_, texture_filter);
+
+    source_texture_size_ = source_image.size();
+    source_texture_type_ = source_image.type();
+    source_texture_filter_ = texture_filter;
+  }
+
+  void GLRenderBackend::BindRenderTarget(RenderTarget &render_target, const size_t width, const size_t height, const GLint internal_format) {
+    if (!render_target.frame_buffer_id_ || render_target.width_ != width || render_target.height_ != height || render_target.internal_format_ != internal_format) {
+      ReleaseRenderTarget(render_target);
+
+      glGenFramebuffers(1, &render_target.frame_buffer_id_);
+      glBindFramebuffer(GL_FRAMEBUFFER, render_target.frame_buffer_id_);
+
+      glGenTextures(1, &render_target.texture_id_);
+      glBindTexture(GL_TEXTURE_2D, render_target.texture_id_);
+
+      glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+      glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, render_target.texture_id_, 0);
+
+      GLenum draw_buffers[1] = {GL_COLOR_ATTACHMENT0};
+      glDrawBuffers(1, draw_buffers);
+
+      render_target.width_ = width;
+      render_target.height_ = height;
+      render_target.internal_format_ = internal_format;
+      return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, render_target.frame_buffer_id_);
+  }
+
+  void GLRenderBackend::ReleaseRenderTarget(RenderTarget &render_target) {
+    if (render_target.frame_buffer_id_) {
+      glDeleteFramebuffers(1, &render_target.frame_buffer_id_);
+      glDeleteTextures(1, &render_target.texture_id_);
+    }
+
+    render_target = RenderTarget();
+  }
+
+  void GLRenderBackend::UpdateMesh(const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices) {
+    const bool is_same_grid = gl_mesh_grid_ == grid_mesh && gl_mesh_.vertices_.size() == warped_vertices.size();
+
+    gl_mesh_.vertices_.resize(warped_vertices.size());
+
+    for (size_t vertex_index = 0; vertex_index < warped_vertices.size(); ++vertex_index) {
+      gl_mesh_.vertices_[vertex_index] = glm::vec3(warped_vertices[vertex_index], 0.0f);
+    }
+
+    if (is_same_grid) {
+      gl_mesh_.UpdateVertices(shader_program_);
+      return;
+    }
+
+    gl_mesh_.vertices_type = GL_TRIANGLES;
+    gl_mesh_.texture_flag_ = true;
+    gl_mesh_.indices_.assign(grid_mesh.indices_.begin(), grid_mesh.indices_.end());
+
+    gl_mesh_.attributes_.clear();
+    for (const auto &uv : grid_mesh.uvs_) {
+      gl_mesh_.attributes_.push_back(TextureVertexAttributes(uv));
+    }
+
+    gl_mesh_.Upload(shader_program_);
+
+    gl_mesh_grid_.image_size_ = grid_mesh.image_size_;
+    gl_mesh_grid_.column_count_ = grid_mesh.column_count_;
+    gl_mesh_grid_.row_count_ = grid_mesh.row_count_;
+  }
+
+  void GLRenderBackend::UpdateAtlasMesh(const GridMesh &grid_mesh, const std::vector<std::vector<glm::vec2> > &warped_vertices_batch, const size_t first_cell,
+    const size_t cell_count, const size_t atlas_columns) {
+    const size_t vertices_per_mesh = grid_mesh.uvs_.size();
+
+    // An atlas with fewer cells than the mesh holds only draws the first ones
+    const bool is_same_grid = atlas_mesh_grid_ == grid_mesh && atlas_mesh_cell_count_ >= cell_count;
+
+    if (!is_same_grid) {
+      atlas_mesh_.vertices_type = GL_TRIANGLES;
+      atlas_mesh_.texture_flag_ = true;
+      atlas_mesh_.indices_.assign(grid_mesh.indices_.begin(), grid_mesh.indices_.end());
+
+      atlas_mesh_.vertices_.resize(cell_count * vertices_per_mesh);
+
+      atlas_mesh_.attributes_.clear();
+      for (size_t cell_index = 0; cell_index < cell_count; ++cell_index) {
+        for (const auto &uv : grid_mesh.uvs_) {
+          atlas_mesh_.attributes_.push_back(TextureVertexAttributes(uv));
+        }
+      }
+    }
+
+    for (size_t cell_index = 0; cell_index < cell_count; ++cell_index) {
+      const std::vector<glm::vec2> &warped_vertices = warped_vertices_batch[first_cell + cell_index];
+      const glm::vec2 cell_offset((cell_index % atlas_columns) * grid_mesh.image_size_.width, (cell_index / atlas_columns) * grid_mesh.image_size_.height);
+      glm::vec3 *vertices = &atlas_mesh_.vertices_[cell_index * vertices_per_mesh];
+
+      for (size_t vertex_index = 0; vertex_index < vertices_per_mesh; ++vertex_index) {
+        vertices[vertex_index] = glm::vec3(warped_vertices[vertex_index] + cell_offset, 0.0f);
+      }
+    }
+
+    if (is_same_grid) {
+      atlas_mesh_.UpdateVertices(shader_program_, 0, cell_count * vertices_per_mesh);
+      return;
+    }
+
+    atlas_mesh_.Upload(shader_program_);
+
+    atlas_mesh_grid_.image_size_ = grid_mesh.image_size_;
+    atlas_mesh_grid_.column_count_ = grid_mesh.column_count_;
+    atlas_mesh_grid_.row_count_ = grid_mesh.row_count_;
+    atlas_mesh_cell_count_ = cell_count;
+  }
+
+  // Places the camera so that the rectangle [0, width] x [0, height] on the z = 0 plane fills the viewport.
+  // The y axis is flipped, so the top of the image lands on the first row glReadPixels returns and no flip is needed after the read back.
+  void GLRenderBackend::SetImagePlaneCamera(const size_t width, const size_t height) {
+    double cotanget_of_half_of_fovy = 1.0 / tan(glm::radians(FOVY / 2.0f));
+
+    glm::vec3 eye_position = glm::vec3(width / 2.0f, height / 2.0f, cotanget_of_half_of_fovy * (height / 2.0));
+    glm::vec3 look_at_position = glm::vec3(width / 2.0f, height / 2.0f, 0);
+
+    float aspect_ratio = width / (float)height;
+
+    glm::mat4 projection_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f)) * glm::perspective(glm::radians(FOVY), aspect_ratio, 0.01f, 10000.0f);
+
+    glm::mat4 view_matrix = glm::lookAt(eye_position, look_at_position, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    glUniformMatrix4fv(shader_program_.uniform_projection_matrix_id_, 1, GL_FALSE, glm::value_ptr(projection_matrix));
+    glUniformMatrix4fv(shader_program_.uniform_view_matrix_id_, 1, GL_FALSE, glm::value_ptr(view_matrix));
+  }
+
+  cv::Mat GLRenderBackend::Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+    const TextureFilter texture_filter) {
+    cv::Mat warped_image = frame_arena_.Image(source_image.size(), source_image.type());
+    Render(source_image, grid_mesh, warped_vertices, texture_filter, warped_image);
+    return warped_image;
+  }
+
+  void GLRenderBackend::Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+    const TextureFilter texture_filter, cv::Mat &warped_image) {
+
+    shader_program_.Use();
+
+    UploadSourceTexture(source_image, texture_filter);
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::TEXTURE_UPLOAD);
+      UpdateMesh(grid_mesh, warped_vertices);
+    }
+
+    gl_mesh_.texture_id_ = source_texture_id_;
+
+    GLint old_frame_buffer;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_frame_buffer);
+
+    BindRenderTarget(frame_render_target_, source_image.cols, source_image.rows, RenderedFormat(source_image.type()));
+
+    glViewport(0, 0, source_image.cols, source_image.rows);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    SetImagePlaneCamera(source_image.cols, source_image.rows);
+
+    glm::mat4 modelview_matrix = glm::mat4(1.0f);
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::DRAW);
+      MORPH_PROFILE_COUNT(ProfileCounter::DRAWN_TRIANGLES, grid_mesh.indices_.size() / 3);
+
+      BlendingDisabledScope blending_disabled_scope;
+
+      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+      gl_mesh_.Draw(shader_program_, modelview_matrix);
+    }
+
+    if (DRAW_MESH) {
+      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+      gl_mesh_.texture_flag_ = false;
+      gl_mesh_.Draw(shader_program_, modelview_matrix);
+      gl_mesh_.texture_flag_ = true;
+    }
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::READBACK);
+
+      warped_image.create(source_image.size(), source_image.type());
+
+      MORPH_PROFILE_COUNT(ProfileCounter::READ_BACK_BYTES, warped_image.total() * warped_image.elemSize());
+
+      // Rows are written with the step of warped_image, only a step that is not a whole number of pixels goes through an arena image
+      const GLint pack_row_length = GLTexture::RowLength(warped_image);
+      cv::Mat read_image = pack_row_length ? warped_image : frame_arena_.Image(source_image.size(), source_image.type());
+
+      glPixelStorei(GL_PACK_ROW_LENGTH, GLTexture::RowLength(read_image));
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glReadPixels(0, 0, source_image.cols, source_image.rows, ReadBackFormat(source_image.type()), ReadBackDataType(source_image.type()), read_image.data);
+      glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+      if (!pack_row_length) {
+        read_image.copyTo(warped_image);
+      }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, old_frame_buffer);
+  }
+
+  void GLRenderBackend::RenderBatch(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<std::vector<glm::vec2> > &warped_vertices_batch,
+    const TextureFilter texture_filter, std::vector<cv::Mat> &warped_images) {
+
+    warped_images.clear();
+
+    if (!warped_vertices_batch.size()) {
+      return;
+    }
+
+    shader_program_.Use();
+
+    GLint max_texture_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+    GLint max_viewport_dimensions[2];
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, max_viewport_dimensions);
+
+    const size_t max_atlas_columns = std::max(1, std::min(max_texture_size, max_viewport_dimensions[0]) / source_image.cols);
+    const size_t max_atlas_rows = std::max(1, std::min(max_texture_size, max_viewport_dimensions[1]) / source_image.rows);
+    const size_t max_cells_per_atlas = max_atlas_columns * max_atlas_rows;
+
+    const size_t vertices_per_mesh = grid_mesh.uvs_.size();
+
+    UploadSourceTexture(source_image, texture_filter);
+
+    GLint old_frame_buffer;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_frame_buffer);
+
+    for (size_t first_cell = 0; first_cell < warped_vertices_batch.size(); first_cell += max_cells_per_atlas) {
+      const size_t cell_count = std::min(warped_vertices_batch.size() - first_cell, max_cells_per_atlas);
+
+      size_t atlas_columns = std::min(max_atlas_columns, (size_t)std::ceil(std::sqrt((double)cell_count)));
+      size_t atlas_rows = (cell_count + atlas_columns - 1) / atlas_columns;
+      if (atlas_rows > max_atlas_rows) {
+        atlas_columns = max_atlas_columns;
+        atlas_rows = (cell_count + atlas_columns - 1) / atlas_columns;
+      }
+
+      const size_t atlas_width = atlas_columns * source_image.cols;
+      const size_t atlas_height = atlas_rows * source_image.rows;
+
+      {
+        MORPH_PROFILE_SCOPE(ProfileStage::TEXTURE_UPLOAD);
+        UpdateAtlasMesh(grid_mesh, warped_vertices_batch, first_cell, cell_count, atlas_columns);
+      }
+
+      atlas_mesh_.texture_id_ = source_texture_id_;
+
+      BindRenderTarget(atlas_render_target_, atlas_width, atlas_height, RenderedFormat(source_image.type()));
+
+      glViewport(0, 0, atlas_width, atlas_height);
+
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      SetImagePlaneCamera(atlas_width, atlas_height);
+
+      {
+        MORPH_PROFILE_SCOPE(ProfileStage::DRAW);
+        MORPH_PROFILE_COUNT(ProfileCounter::DRAWN_TRIANGLES, cell_count * grid_mesh.indices_.size() / 3);
+
+        BlendingDisabledScope blending_disabled_scope;
+
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        atlas_mesh_.DrawBatch(shader_program_, glm::mat4(1.0f), cell_count, vertices_per_mesh);
+      }
+
+      cv::Mat atlas_image = frame_arena_.Image(cv::Size(atlas_width, atlas_height), source_image.type());
+
+      {
+        MORPH_PROFILE_SCOPE(ProfileStage::READBACK);
+        MORPH_PROFILE_COUNT(ProfileCounter::READ_BACK_BYTES, atlas_image.total() * atlas_image.elemSize());
+
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glReadPixels(0, 0, atlas_width, atlas_height, ReadBackFormat(source_image.type()), ReadBackDataType(source_image.type()), atlas_image.data);
+      }
+
+      for (size_t cell_index = 0; cell_index < cell_count; ++cell_index) {
+        size_t cell_column = cell_index % atlas_columns;
+        size_t cell_row = cell_index / atlas_columns;
+        cv::Rect cell_rect(cell_column * source_image.cols, atlas_height - (cell_row + 1) * source_image.rows, source_image.cols, source_image.rows);
+        warped_images.push_back(atlas_image(cell_rect));
+      }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, old_frame_buffer);
+  }
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "frame_arena.h"
+#include "gl_mesh.h"
+#include "gl_shader.h"
+#include "render_backend.h"
+
+namespace ImageMorphing {
+
+  // Renders the warped grid mesh with OpenGL into an offscreen frame buffer.
+  // The GL context the backend is initialized in must be current on the calling thread whenever it is used.
+  class GLRenderBackend : public RenderBackend {
+
+  public:
+
+    GLRenderBackend();
+
+    ~GLRenderBackend();
+
+    bool Initialize(const std::string &vertex_shader_source, const std::string &fragment_shader_source, const std::string &shader_cache_directory, std::string &info_log);
+
+    cv::Mat Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+      const TextureFilter texture_filter) override;
+
+    // Reads back straight into warped_image when its rows are contiguous
+    void Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+      const TextureFilter texture_filter, cv::Mat &warped_image) override;
+
+    using RenderBackend::RenderBatch;
+
+    // Renders one warped copy of source_image per entry of warped_vertices_batch into a shared atlas with a single draw call,
+    // then reads the whole atlas back at once. The warped images are views into the atlas.
+    void RenderBatch(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<std::vector<glm::vec2> > &warped_vertices_batch,
+      const TextureFilter texture_filter, std::vector<cv::Mat> &warped_images) override;
+
+  private:
+
+    // Frame buffer rendering into one color texture
+    struct RenderTarget {
+
+      RenderTarget() : frame_buffer_id_(0), texture_id_(0), width_(0), height_(0), internal_format_(0) {
+      }
+
+      GLuint frame_buffer_id_;
+      GLuint texture_id_;
+      size_t width_;
+      size_t height_;
+      GLint internal_format_;
+    };
+
+    // Grid a mesh was built for, its uvs and indices only change with it
+    struct MeshGrid {
+
+      MeshGrid() : column_count_(0), row_count_(0) {
+      }
+
+      bool operator ==(const GridMesh &grid_mesh) const {
+        return image_size_ == grid_mesh.image_size_ && column_count_ == grid_mesh.column_count_ && row_count_ == grid_mesh.row_count_;
+      }
+
+      cv::Size image_size_;
+      size_t column_count_;
+      size_t row_count_;
+    };
+
+    void SetImagePlaneCamera(const size_t width, const size_t height);
+
+    // Uploads source_image into source_texture_id_, reallocating the texture only when its size, type or filter changed
+    void UploadSourceTexture(const cv::Mat &source_image, const TextureFilter texture_filter);
+
+    // Rebuilds render_target only when its size or format changed, then binds its frame buffer
+    void BindRenderTarget(RenderTarget &render_target, const size_t width, const size_t height, const GLint internal_format);
+
+    void ReleaseRenderTarget(RenderTarget &render_target);
+
+    // Uploads the whole mesh when the grid differs from the one gl_mesh_ was built for, otherwise only the moved vertices
+    void UpdateMesh(const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices);
+
+    // Same for atlas_mesh_, which holds the grid cell_count times
+    void UpdateAtlasMesh(const GridMesh &grid_mesh, const std::vector<std::vector<glm::vec2> > &warped_vertices_batch, const size_t first_cell,
+      const size_t cell_count, const size_t atlas_columns);
+
+    GLShaderProgram shader_program_;
+
+    // GL objects kept from frame to frame. Only the vertex positions and the texels of the source are uploaded
+    // for every frame, as long as the grid and the frame size stay the same.
+    GLMesh gl_mesh_;
+    MeshGrid gl_mesh_grid_;
+    GLMesh atlas_mesh_;
+    MeshGrid atlas_mesh_grid_;
+    size_t atlas_mesh_cell_count_;
+    RenderTarget frame_render_target_;
+    RenderTarget atlas_render_target_;
+    GLuint source_texture_id_;
+    cv::Size source_texture_size_;
+    int source_texture_type_;
+    TextureFilter source_texture_filter_;
+
+    // Read back frames and atlases
+    FrameArena frame_arena_;
+  };
+
+}
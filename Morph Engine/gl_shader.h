@@ -0,0 +1,342 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <GL/glew.h>
+
+namespace ImageMorphing {
+
+  const std::string SHADER_ATTRIBUTE_VERTEX_POSITION_NAME = "vertex_position";
+  const std::string SHADER_ATTRIBUTE_VERTEX_COLOR_NAME = "vertex_color";
+  const std::string SHADER_ATTRIBUTE_VERTEX_UV_NAME = "vertex_uv";
+
+  const std::string SHADER_UNIFORM_MODELVIEW_MATRIX_NAME = "modelview_matrix";
+  const std::string SHADER_UNIFORM_VIEW_MATRIX_NAME = "view_matrix";
+  const std::string SHADER_UNIFORM_PROJECTION_MATRIX_NAME = "projection_matrix";
+  const std::string SHADER_UNIFORM_TEXTURE_NAME = "texture";
+  const std::string SHADER_UNIFORM_TEXTURE_FLAG_NAME = "texture_flag";
+
+  namespace GLShader {
+
+    const uint32_t PROGRAM_BINARY_FILE_MAGIC = 0x4d495350; // "PSIM"
+
+    // FNV-1a, stable across runs and compilers so it can name files in the cache
+    inline uint64_t HashString(const std::string &string, uint64_t hash = 14695981039346656037ULL) {
+      for (const unsigned char c : string) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+      }
+      return hash;
+    }
+
+    inline std::string HashToHexString(uint64_t hash) {
+      char hex_string[17];
+      std::snprintf(hex_string, sizeof(hex_string), "%016llx", (unsigned long long)hash);
+      return hex_string;
+    }
+
+    inline std::string GetDriverString() {
+      std::string driver_string;
+      for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte *value = glGetString(name);
+        driver_string += value ? (const char *)value : "";
+        driver_string += '\n';
+      }
+      return driver_string;
+    }
+
+    inline bool IsProgramBinarySupported() {
+      if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+        return false;
+      }
+      GLint binary_formats_count = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats_count);
+      return binary_formats_count > 0;
+    }
+
+    inline GLuint CompileShader(GLenum shader_type, const std::string &shader_source, std::string &info_log) {
+      GLuint shader = glCreateShader(shader_type);
+      const GLchar *shader_source_pointer = (const GLchar *)shader_source.c_str();
+      glShaderSource(shader, 1, &shader_source_pointer, NULL);
+      glCompileShader(shader);
+
+      int shader_compile_status;
+      glGetShaderiv(shader, GL_COMPILE_STATUS, &shader_compile_status);
+      if (shader_compile_status != GL_TRUE) {
+        GLint info_log_length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
+        std::vector<GLchar> info_log_buffer(info_log_length + 1, 0);
+        glGetShaderInfoLog(shader, info_log_length, NULL, info_log_buffer.data());
+        info_log = info_log_buffer.data();
+        glDeleteShader(shader);
+        return 0;
+      }
+
+      return shader;
+    }
+
+    inline bool CheckProgramLinkStatus(GLuint program_id, std::string &info_log) {
+      int program_link_status;
+      glGetProgramiv(program_id, GL_LINK_STATUS, &program_link_status);
+      if (program_link_status == GL_TRUE) {
+        return true;
+      }
+
+      GLint info_log_length = 0;
+      glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_log_length);
+      std::vector<GLchar> info_log_buffer(info_log_length + 1, 0);
+      glGetProgramInfoLog(program_id, info_log_length, NULL, info_log_buffer.data());
+      info_log = info_log_buffer.data();
+      return false;
+    }
+
+    inline GLuint CompileProgram(const std::string &vertex_shader_source, const std::string &fragment_shader_source, bool retrievable_binary, std::string &info_log) {
+      GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, vertex_shader_source, info_log);
+      if (!vertex_shader) {
+        info_log = "Could not compile the vertex shader.\n" + info_log;
+        return 0;
+      }
+
+      GLuint fragment_shader = CompileShader(GL_FRAGMENT_SHADER, fragment_shader_source, info_log);
+      if (!fragment_shader) {
+        info_log = "Could not compile the fragment shader.\n" + info_log;
+        glDeleteShader(vertex_shader);
+        return 0;
+      }
+
+      GLuint program_id = glCreateProgram();
+      glAttachShader(program_id, vertex_shader);
+      glAttachShader(program_id, fragment_shader);
+
+      if (retrievable_binary) {
+        glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+      }
+
+      glLinkProgram(program_id);
+
+      glDetachShader(program_id, vertex_shader);
+      glDetachShader(program_id, fragment_shader);
+      glDeleteShader(vertex_shader);
+      glDeleteShader(fragment_shader);
+
+      if (!CheckProgramLinkStatus(program_id, info_log)) {
+        info_log = "Could not link the shader.\n" + info_log;
+        glDeleteProgram(program_id);
+        return 0;
+      }
+
+      return program_id;
+    }
+
+    // Cache file layout: magic, binary format, key hash, binary length, binary
+    inline GLuint LoadProgramBinary(const std::string &cache_file_path, uint64_t key_hash) {
+      std::ifstream cache_file_stream(cache_file_path, std::ios::binary);
+      if (!cache_file_stream.is_open()) {
+        return 0;
+      }
+
+      uint32_t magic = 0;
+      uint32_t binary_format = 0;
+      uint64_t cached_key_hash = 0;
+      uint64_t binary_length = 0;
+
+      cache_file_stream.read((char *)&magic, sizeof(magic));
+      cache_file_stream.read((char *)&binary_format, sizeof(binary_format));
+      cache_file_stream.read((char *)&cached_key_hash, sizeof(cached_key_hash));
+      cache_file_stream.read((char *)&binary_length, sizeof(binary_length));
+
+      if (!cache_file_stream || magic != PROGRAM_BINARY_FILE_MAGIC || cached_key_hash != key_hash || !binary_length) {
+        return 0;
+      }
+
+      std::vector<char> binary(binary_length);
+      if (!cache_file_stream.read(binary.data(), binary.size())) {
+        return 0;
+      }
+
+      GLuint program_id = glCreateProgram();
+      glProgramBinary(program_id, binary_format, binary.data(), binary.size());
+
+      // The driver rejects binaries it cannot use any more, e.g. after an update
+      std::string info_log;
+      if (!CheckProgramLinkStatus(program_id, info_log)) {
+        glDeleteProgram(program_id);
+        return 0;
+      }
+
+      return program_id;
+    }
+
+    inline bool SaveProgramBinary(const std::string &cache_file_path, uint64_t key_hash, GLuint program_id) {
+      GLint binary_length = 0;
+      glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+      if (binary_length <= 0) {
+        return false;
+      }
+
+      std::vector<char> binary(binary_length);
+      GLenum binary_format = 0;
+      glGetProgramBinary(program_id, binary_length, NULL, &binary_format, binary.data());
+
+      // Write next to the final file first so a concurrent worker never reads a half written binary
+      const std::string temporary_file_path = cache_file_path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+      {
+        std::ofstream cache_file_stream(temporary_file_path, std::ios::binary | std::ios::trunc);
+        if (!cache_file_stream.is_open()) {
+          return false;
+        }
+
+        uint32_t magic = PROGRAM_BINARY_FILE_MAGIC;
+        uint32_t binary_format_value = binary_format;
+        uint64_t binary_length_value = binary_length;
+
+        cache_file_stream.write((const char *)&magic, sizeof(magic));
+        cache_file_stream.write((const char *)&binary_format_value, sizeof(binary_format_value));
+        cache_file_stream.write((const char *)&key_hash, sizeof(key_hash));
+        cache_file_stream.write((const char *)&binary_length_value, sizeof(binary_length_value));
+        cache_file_stream.write(binary.data(), binary.size());
+
+        if (!cache_file_stream) {
+          std::remove(temporary_file_path.c_str());
+          return false;
+        }
+      }
+
+      std::remove(cache_file_path.c_str());
+      if (std::rename(temporary_file_path.c_str(), cache_file_path.c_str())) {
+        std::remove(temporary_file_path.c_str());
+        return false;
+      }
+
+      return true;
+    }
+
+    inline void MakeDirectory(const std::string &directory_path) {
+#ifdef _WIN32
+      _mkdir(directory_path.c_str());
+#else
+      mkdir(directory_path.c_str(), 0755);
+#endif
+    }
+
+    // Returns the linked program, or 0 with the reason in info_log. When cache_directory is not empty the program binary
+    // is looked up there first, keyed by the shader sources and the driver, and stored there after a fresh compile.
+    inline GLuint LoadProgram(const std::string &vertex_shader_source, const std::string &fragment_shader_source,
+      const std::string &cache_directory, std::string &info_log) {
+
+      const bool use_cache = !cache_directory.empty() && IsProgramBinarySupported();
+
+      uint64_t key_hash = 0;
+      std::string cache_file_path;
+
+      if (use_cache) {
+        key_hash = HashString(vertex_shader_source);
+        key_hash = HashString(std::string(1, '\0') + fragment_shader_source, key_hash);
+        key_hash = HashString(std::string(1, '\0') + GetDriverString(), key_hash);
+
+        cache_file_path = cache_directory + "/program_" + HashToHexString(key_hash) + ".bin";
+
+        GLuint program_id = LoadProgramBinary(cache_file_path, key_hash);
+        if (program_id) {
+          return program_id;
+        }
+      }
+
+      GLuint program_id = CompileProgram(vertex_shader_source, fragment_shader_source, use_cache, info_log);
+
+      if (program_id && use_cache) {
+        MakeDirectory(cache_directory);
+        if (!SaveProgramBinary(cache_file_path, key_hash, program_id)) {
+          std::cerr << "Could not write the shader cache " << cache_file_path << ".\n";
+        }
+      }
+
+      return program_id;
+    }
+
+  };
+
+  // The program used to draw every GLMesh, with the locations of its attributes and uniforms
+  struct GLShaderProgram {
+
+    GLShaderProgram() : program_id_(0), attribute_vertex_position_id_(-1), attribute_vertex_color_id_(-1), attribute_vertex_uv_id_(-1),
+      uniform_modelview_matrix_id_(-1), uniform_view_matrix_id_(-1), uniform_projection_matrix_id_(-1), uniform_texture_id_(-1), uniform_texture_flag_id_(-1) {
+    }
+
+    bool Load(const std::string &vertex_shader_source, const std::string &fragment_shader_source, const std::string &cache_directory, std::string &info_log) {
+      Release();
+
+      program_id_ = GLShader::LoadProgram(vertex_shader_source, fragment_shader_source, cache_directory, info_log);
+      if (!program_id_) {
+        return false;
+      }
+
+      attribute_vertex_position_id_ = GetAttributeLocation(SHADER_ATTRIBUTE_VERTEX_POSITION_NAME);
+      attribute_vertex_color_id_ = GetAttributeLocation(SHADER_ATTRIBUTE_VERTEX_COLOR_NAME);
+      attribute_vertex_uv_id_ = GetAttributeLocation(SHADER_ATTRIBUTE_VERTEX_UV_NAME);
+
+      uniform_modelview_matrix_id_ = GetUniformLocation(SHADER_UNIFORM_MODELVIEW_MATRIX_NAME);
+      uniform_view_matrix_id_ = GetUniformLocation(SHADER_UNIFORM_VIEW_MATRIX_NAME);
+      uniform_projection_matrix_id_ = GetUniformLocation(SHADER_UNIFORM_PROJECTION_MATRIX_NAME);
+      uniform_texture_id_ = GetUniformLocation(SHADER_UNIFORM_TEXTURE_NAME);
+      uniform_texture_flag_id_ = GetUniformLocation(SHADER_UNIFORM_TEXTURE_FLAG_NAME);
+
+      return true;
+    }
+
+    void Release() {
+      if (program_id_) {
+        glDeleteProgram(program_id_);
+      }
+      program_id_ = 0;
+    }
+
+    void Use() const {
+      glUseProgram(program_id_);
+    }
+
+    GLuint program_id_;
+    GLint attribute_vertex_position_id_;
+    GLint attribute_vertex_color_id_;
+    GLint attribute_vertex_uv_id_;
+    GLint uniform_modelview_matrix_id_;
+    GLint uniform_view_matrix_id_;
+    GLint uniform_projection_matrix_id_;
+    GLint uniform_texture_id_;
+    GLint uniform_texture_flag_id_;
+
+  private:
+
+    GLint GetAttributeLocation(const std::string &name) const {
+      GLint location = glGetAttribLocation(program_id_, name.c_str());
+      if (location == -1) {
+        std::cerr << "Could not bind attribute " << name << ".\n";
+      }
+      return location;
+    }
+
+    GLint GetUniformLocation(const std::string &name) const {
+      GLint location = glGetUniformLocation(program_id_, name.c_str());
+      if (location == -1) {
+        std::cerr << "Could not bind uniform " << name << ".\n";
+      }
+      return location;
+    }
+  };
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <opencv2/core.hpp>
+
+#include "texture_filter.h"
+
+namespace ImageMorphing {
+
+  const float MAX_TEXTURE_ANISOTROPY = 16.0f;
+
+  namespace GLTexture {
+
+    inline bool IsMipmappedTextureFilter(TextureFilter texture_filter) {
+      return texture_filter == TextureFilter::TRILINEAR || texture_filter == TextureFilter::ANISOTROPIC;
+    }
+
+    inline void SetGLTextureFilter(TextureFilter texture_filter) {
+      switch (texture_filter) {
+      case TextureFilter::NEAREST:
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        break;
+      case TextureFilter::BILINEAR:
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        break;
+      case TextureFilter::TRILINEAR:
+      case TextureFilter::ANISOTROPIC:
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        break;
+      }
+
+      if (texture_filter == TextureFilter::ANISOTROPIC && GLEW_EXT_texture_filter_anisotropic) {
+        GLfloat max_anisotropy;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(max_anisotropy, MAX_TEXTURE_ANISOTROPY));
+      }
+    }
+
+    // GL type of the samples of images of OpenCV depth
+    inline GLenum PixelDataType(int depth) {
+      switch (depth) {
+      case CV_16U:
+        return GL_UNSIGNED_SHORT;
+      case CV_32F:
+        return GL_FLOAT;
+      default:
+        return GL_UNSIGNED_BYTE;
+      }
+    }
+
+    // Internal format keeping the precision of samples of data_type
+    inline GLint InternalTextureFormat(GLenum format, GLenum data_type) {
+      const bool has_alpha = format == GL_RGBA || format == GL_BGRA;
+
+      switch (data_type) {
+      case GL_UNSIGNED_SHORT:
+        return has_alpha ? GL_RGBA16 : GL_RGB16;
+      case GL_FLOAT:
+        return has_alpha ? GL_RGBA32F : GL_RGB32F;
+      default:
+        return has_alpha ? GL_RGBA : GL_RGB;
+      }
+    }
+
+    // format is GL_RGB or GL_BGR, GL_RGBA or GL_BGRA for images with alpha, data_type is GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_FLOAT
+    inline void SetGLTexture(void *image_data_pointer, int width, int height, GLuint *texture_id, TextureFilter texture_filter = TextureFilter::NEAREST,
+      GLenum format = GL_RGB, GLenum data_type = GL_UNSIGNED_BYTE) {
+      glDeleteTextures(1, texture_id);
+
+      glGenTextures(1, texture_id);
+      glBindTexture(GL_TEXTURE_2D, *texture_id);
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+      SetGLTextureFilter(texture_filter);
+
+      glTexImage2D(GL_TEXTURE_2D, 0, InternalTextureFormat(format, data_type), width, height, 0, format, data_type, image_data_pointer);
+
+      // The mipmap chain is built by the driver right after the upload, so it never goes through the CPU
+      if (IsMipmappedTextureFilter(texture_filter)) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+      }
+    }
+
+    // Replaces the texels of texture_id, which SetGLTexture set up with the same size, format, data type and filter
+    inline void UpdateGLTexture(void *image_data_pointer, int width, int height, GLuint texture_id, TextureFilter texture_filter = TextureFilter::NEAREST,
+      GLenum format = GL_RGB, GLenum data_type = GL_UNSIGNED_BYTE) {
+      glBindTexture(GL_TEXTURE_2D, texture_id);
+
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, data_type, image_data_pointer);
+
+      if (IsMipmappedTextureFilter(texture_filter)) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+      }
+    }
+
+    // Pixels per row of cv_image for GL_UNPACK_ROW_LENGTH and GL_PACK_ROW_LENGTH, 0 when its row step is not a whole number of pixels
+    inline GLint RowLength(const cv::Mat &cv_image) {
+      return cv_image.step[0] % cv_image.elemSize() ? 0 : (GLint)(cv_image.step[0] / cv_image.elemSize());
+    }
+
+    // BGR images of any supported depth or premultiplied BGRA images, uploaded as they are so the texture stays premultiplied.
+    // The driver swizzles the channels and reads the rows with their step. The rows stay top down, so the texture is upside
+    // down for OpenGL and the uvs sampling it must count v from the top.
+    inline void SetGLTexture(const cv::Mat &cv_image, GLuint *texture_id, TextureFilter texture_filter = TextureFilter::NEAREST) {
+      const cv::Mat image_for_gl_texture = RowLength(cv_image) ? cv_image : cv_image.clone();
+
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, RowLength(image_for_gl_texture));
+      SetGLTexture(image_for_gl_texture.data, image_for_gl_texture.cols, image_for_gl_texture.rows, texture_id, texture_filter,
+        image_for_gl_texture.channels() == 4 ? GL_BGRA : GL_BGR, PixelDataType(image_for_gl_texture.depth()));
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    // Same as above, into a texture SetGLTexture set up for an image of the same size and type
+    inline void UpdateGLTexture(const cv::Mat &cv_image, GLuint texture_id, TextureFilter texture_filter = TextureFilter::NEAREST) {
+      const cv::Mat image_for_gl_texture = RowLength(cv_image) ? cv_image : cv_image.clone();
+
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, RowLength(image_for_gl_texture));
+      UpdateGLTexture(image_for_gl_texture.data, image_for_gl_texture.cols, image_for_gl_texture.rows, texture_id, texture_filter,
+        image_for_gl_texture.channels() == 4 ? GL_BGRA : GL_BGR, PixelDataType(image_for_gl_texture.depth()));
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+  };
+
+}
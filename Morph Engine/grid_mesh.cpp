@@ -0,0 +1,75 @@
+#include "grid_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ImageMorphing {
+
+  GridMesh::GridMesh() : column_count_(0), row_count_(0) {
+  }
+
+  GridMesh::GridMesh(const cv::Size &image_size, const size_t grid_size) : image_size_(image_size) {
+    column_count_ = (size_t)(image_size.width / grid_size) + 1;
+    row_count_ = (size_t)(image_size.height / grid_size) + 1;
+
+    float real_mesh_width = image_size.width / (float)(column_count_ - 1);
+    float real_mesh_height = image_size.height / (float)(row_count_ - 1);
+
+    for (size_t r = 0; r < row_count_; ++r) {
+      for (size_t c = 0; c < column_count_; ++c) {
+        glm::vec2 vertex(c * real_mesh_width, r * real_mesh_height);
+        graph_.vertices_.push_back(vertex);
+        uvs_.push_back(glm::vec2(vertex.x / (float)image_size.width, vertex.y / (float)image_size.height));
+      }
+    }
+
+    for (size_t r = 0; r < row_count_ - 1; ++r) {
+      for (size_t c = 0; c < column_count_ - 1; ++c) {
+        std::vector<size_t> vertex_indices;
+
+        size_t base_index = VertexIndex(r, c);
+        vertex_indices.push_back(base_index);
+        vertex_indices.push_back(base_index + column_count_);
+        vertex_indices.push_back(base_index + column_count_ + 1);
+        vertex_indices.push_back(base_index + 1);
+
+        if (!c) {
+          graph_.edges_.push_back(Edge(std::make_pair(vertex_indices[0], vertex_indices[1])));
+        }
+
+        graph_.edges_.push_back(Edge(std::make_pair(vertex_indices[1], vertex_indices[2])));
+        graph_.edges_.push_back(Edge(std::make_pair(vertex_indices[3], vertex_indices[2])));
+
+        if (!r) {
+          graph_.edges_.push_back(Edge(std::make_pair(vertex_indices[0], vertex_indices[3])));
+        }
+
+        // Two triangles per grid cell, sharing the vertices with the neighbouring cells
+        indices_.push_back(vertex_indices[0]);
+        indices_.push_back(vertex_indices[1]);
+        indices_.push_back(vertex_indices[2]);
+
+        indices_.push_back(vertex_indices[0]);
+        indices_.push_back(vertex_indices[2]);
+        indices_.push_back(vertex_indices[3]);
+      }
+    }
+  }
+
+  size_t CappedGridSize(const cv::Size &image_size, const size_t grid_size, const size_t max_vertex_count) {
+    if (!max_vertex_count) {
+      return grid_size;
+    }
+
+    // A cell of area / max_vertex_count pixels is a lower bound, the + 1 vertices of every row and column need a bit more
+    const size_t max_side = (size_t)std::max(image_size.width, image_size.height);
+    size_t capped_grid_size = std::max(grid_size, (size_t)std::sqrt(image_size.area() / (double)max_vertex_count));
+
+    while (capped_grid_size < max_side && (image_size.width / capped_grid_size + 1) * (image_size.height / capped_grid_size + 1) > max_vertex_count) {
+      ++capped_grid_size;
+    }
+
+    return capped_grid_size;
+  }
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "graph.h"
+
+namespace ImageMorphing {
+
+  // Regular grid laid over an image. The vertices are in OpenGL coordinates (y axis points up),
+  // the uvs map every vertex back to its rest position in the image.
+  class GridMesh {
+
+  public:
+
+    GridMesh();
+
+    GridMesh(const cv::Size &image_size, const size_t grid_size);
+
+    size_t VertexIndex(const size_t row, const size_t column) const {
+      return row * column_count_ + column;
+    }
+
+    cv::Size image_size_;
+
+    size_t column_count_;
+    size_t row_count_;
+
+    Graph<glm::vec2> graph_;
+
+    std::vector<glm::vec2> uvs_;
+
+    // Two triangles per grid cell
+    std::vector<unsigned int> indices_;
+  };
+
+  // Smallest grid size from grid_size up whose mesh over image_size has at most max_vertex_count vertices,
+  // so the mesh and its solve stop growing with the image. A max_vertex_count of 0 keeps grid_size.
+  size_t CappedGridSize(const cv::Size &image_size, const size_t grid_size, const size_t max_vertex_count);
+
+}
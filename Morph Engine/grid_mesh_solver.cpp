@@ -0,0 +1,167 @@
+#define IL_STD
+
+#include "grid_mesh_solver.h"
+
+#include <iostream>
+
+#include <ilcplex/ilocplex.h>
+
+#include "profiler.h"
+
+namespace ImageMorphing {
+
+  const double WARPED_POSITION_WEIGHT = 1;
+
+  struct GridMeshSolver::CplexModel {
+
+    CplexModel() : x_(env_), hard_constraint_(env_), objective_(IloMinimize(env_)), model_(env_), cplex_(env_), values_(env_) {
+    }
+
+    ~CplexModel() {
+      env_.end();
+    }
+
+    IloEnv env_;
+    IloNumVarArray x_;
+    IloRangeArray hard_constraint_;
+    IloObjective objective_;
+    IloModel model_;
+    IloCplex cplex_;
+
+    // Solution of the last solve, kept so every solve reads into the same array
+    IloNumArray values_;
+  };
+
+  GridMeshSolver::GridMeshSolver() : column_count_(0), row_count_(0), thread_count_(0) {
+  }
+
+  GridMeshSolver::~GridMeshSolver() {
+  }
+
+  void GridMeshSolver::SetGridMesh(const GridMesh &grid_mesh) {
+    if (HasGridMesh(grid_mesh)) {
+      return;
+    }
+
+    MORPH_PROFILE_SCOPE(ProfileStage::MODEL_BUILD);
+
+    cplex_model_.reset(new CplexModel());
+
+    image_size_ = grid_mesh.image_size_;
+    column_count_ = grid_mesh.column_count_;
+    row_count_ = grid_mesh.row_count_;
+
+    IloEnv &env = cplex_model_->env_;
+    IloNumVarArray &x = cplex_model_->x_;
+    IloRangeArray &hard_constraint = cplex_model_->hard_constraint_;
+
+    const glm::vec2 &origin = grid_mesh.graph_.vertices_[0];
+
+    for (size_t vertex_index = 0; vertex_index < grid_mesh.graph_.vertices_.size(); ++vertex_index) {
+      x.add(IloNumVar(env, origin.x, origin.x + image_size_.width));
+      x.add(IloNumVar(env, origin.y, origin.y + image_size_.height));
+    }
+
+    // Boundary constraint
+    for (size_t row = 0; row < row_count_; ++row) {
+      size_t vertex_index = grid_mesh.VertexIndex(row, 0);
+      hard_constraint.add(x[vertex_index * 2] == origin.x);
+
+      vertex_index = grid_mesh.VertexIndex(row, column_count_ - 1);
+      hard_constraint.add(x[vertex_index * 2] == origin.x + image_size_.width);
+    }
+
+    for (size_t column = 0; column < column_count_; ++column) {
+      size_t vertex_index = grid_mesh.VertexIndex(0, column);
+      hard_constraint.add(x[vertex_index * 2 + 1] == origin.y);
+
+      vertex_index = grid_mesh.VertexIndex(row_count_ - 1, column);
+      hard_constraint.add(x[vertex_index * 2 + 1] == origin.y + image_size_.height);
+    }
+
+    // Avoid flipping
+    for (size_t row = 0; row < row_count_; ++row) {
+      for (size_t column = 1; column < column_count_; ++column) {
+        size_t vertex_index_right = grid_mesh.VertexIndex(row, column);
+        size_t vertex_index_left = grid_mesh.VertexIndex(row, column - 1);
+        hard_constraint.add((x[vertex_index_right * 2] - x[vertex_index_left * 2]) >= 1e-4);
+      }
+    }
+
+    for (size_t row = 1; row < row_count_; ++row) {
+      for (size_t column = 0; column < column_count_; ++column) {
+        size_t vertex_index_down = grid_mesh.VertexIndex(row, column);
+        size_t vertex_index_up = grid_mesh.VertexIndex(row - 1, column);
+        hard_constraint.add((x[vertex_index_down * 2 + 1] - x[vertex_index_up * 2 + 1]) >= 1e-4);
+      }
+    }
+
+    cplex_model_->model_.add(cplex_model_->objective_);
+    cplex_model_->model_.add(hard_constraint);
+
+    cplex_model_->cplex_.extract(cplex_model_->model_);
+    cplex_model_->cplex_.setOut(env.getNullStream());
+    cplex_model_->cplex_.setParam(IloCplex::Param::Threads, (IloInt)thread_count_);
+  }
+
+  void GridMeshSolver::SetThreadCount(const size_t thread_count) {
+    if (thread_count == thread_count_) {
+      return;
+    }
+
+    thread_count_ = thread_count;
+
+    if (cplex_model_) {
+      cplex_model_->cplex_.setParam(IloCplex::Param::Threads, (IloInt)thread_count_);
+    }
+  }
+
+  bool GridMeshSolver::Solve(const std::vector<glm::vec2> &target_vertices, std::vector<glm::vec2> &warped_vertices) {
+    warped_vertices = target_vertices;
+
+    if (!cplex_model_ || target_vertices.size() * 2 != (size_t)cplex_model_->x_.getSize()) {
+      std::cerr << "The grid mesh of the solver does not match the targets.\n";
+      return false;
+    }
+
+    IloEnv &env = cplex_model_->env_;
+    IloNumVarArray &x = cplex_model_->x_;
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::MODEL_BUILD);
+
+      IloExpr expr(env);
+
+      for (size_t j = 0; j < target_vertices.size(); ++j) {
+        expr += WARPED_POSITION_WEIGHT * IloPower(x[j * 2] - target_vertices[j].x, 2);
+        expr += WARPED_POSITION_WEIGHT * IloPower(x[j * 2 + 1] - target_vertices[j].y, 2);
+      }
+
+      cplex_model_->objective_.setExpr(expr);
+      expr.end();
+    }
+
+    MORPH_PROFILE_COUNT(ProfileCounter::SOLVES, 1);
+
+    IloNumArray &result = cplex_model_->values_;
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::SOLVE);
+
+      if (!cplex_model_->cplex_.solve()) {
+        std::cerr << "Failed to optimize the model.\n";
+        return false;
+      }
+
+      cplex_model_->cplex_.getValues(result, x);
+    }
+
+    for (size_t vertex_index = 0; vertex_index < warped_vertices.size(); ++vertex_index) {
+      warped_vertices[vertex_index].x = result[vertex_index * 2];
+      warped_vertices[vertex_index].y = result[vertex_index * 2 + 1];
+    }
+
+    return true;
+  }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "grid_mesh.h"
+
+namespace ImageMorphing {
+
+  // Quadratic program placing the vertices of a grid mesh as close as possible to their targets,
+  // while the boundary stays on the image border and no cell flips.
+  // The variables and the hard constraints only depend on the grid topology, so they are built once
+  // and every solve on the same topology only replaces the objective.
+  class GridMeshSolver {
+
+  public:
+
+    GridMeshSolver();
+
+    ~GridMeshSolver();
+
+    void SetGridMesh(const GridMesh &grid_mesh);
+
+    bool HasGridMesh(const GridMesh &grid_mesh) const {
+      return cplex_model_ && image_size_ == grid_mesh.image_size_ && column_count_ == grid_mesh.column_count_ && row_count_ == grid_mesh.row_count_;
+    }
+
+    // Threads CPLEX may use for one solve, 0 lets CPLEX decide
+    void SetThreadCount(const size_t thread_count);
+
+    // On failure warped_vertices is left equal to target_vertices
+    bool Solve(const std::vector<glm::vec2> &target_vertices, std::vector<glm::vec2> &warped_vertices);
+
+  private:
+
+    GridMeshSolver(const GridMeshSolver &) = delete;
+    GridMeshSolver &operator =(const GridMeshSolver &) = delete;
+
+    struct CplexModel;
+
+    std::unique_ptr<CplexModel> cplex_model_;
+
+    cv::Size image_size_;
+    size_t column_count_;
+    size_t row_count_;
+
+    size_t thread_count_;
+  };
+
+}
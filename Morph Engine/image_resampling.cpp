@@ -0,0 +1,91 @@
+#include "image_resampling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/imgproc.hpp>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    // Top left corner of the part of an image of cover_size that FitImage keeps, centered
+    cv::Point FitOffset(const cv::Size &cover_size, const cv::Size &size) {
+      return cv::Point((cover_size.width - size.width) / 2, (cover_size.height - size.height) / 2);
+    }
+
+  }
+
+  cv::Mat ResampleImage(const cv::Mat &image, const cv::Size &size) {
+    if (image.size() == size) {
+      return image;
+    }
+
+    const bool is_shrinking_x = size.width < image.cols;
+    const bool is_shrinking_y = size.height < image.rows;
+
+    cv::Mat resampled_image;
+
+    if (is_shrinking_x == is_shrinking_y) {
+      cv::resize(image, resampled_image, size, 0, 0, is_shrinking_x ? cv::INTER_AREA : cv::INTER_LANCZOS4);
+      return resampled_image;
+    }
+
+    // One axis shrinks and the other grows, each gets its own filter in its own separable pass
+    cv::resize(image, resampled_image, cv::Size(size.width, image.rows), 0, 0, is_shrinking_x ? cv::INTER_AREA : cv::INTER_LANCZOS4);
+    cv::resize(resampled_image, resampled_image, size, 0, 0, is_shrinking_y ? cv::INTER_AREA : cv::INTER_LANCZOS4);
+
+    return resampled_image;
+  }
+
+  cv::Size FitCoverSize(const cv::Size &image_size, const cv::Size &size) {
+    const double scale = std::max(size.width / (double)image_size.width, size.height / (double)image_size.height);
+
+    // The axis setting the scale matches size exactly, the other one rounds to at least size
+    return cv::Size(std::max(size.width, (int)std::lround(image_size.width * scale)), std::max(size.height, (int)std::lround(image_size.height * scale)));
+  }
+
+  cv::Mat FitImage(const cv::Mat &image, const cv::Size &size) {
+    const cv::Size cover_size = FitCoverSize(image.size(), size);
+    const cv::Mat cover_image = ResampleImage(image, cover_size);
+
+    if (cover_size == size) {
+      return cover_image;
+    }
+
+    // Copied, so the cropped bands are freed
+    return cover_image(cv::Rect(FitOffset(cover_size, size), size)).clone();
+  }
+
+  std::vector<FeatureLine> FitFeatureLines(const FeatureLineSpan &feature_lines, const cv::Size &image_size, const cv::Size &size) {
+    const cv::Size cover_size = FitCoverSize(image_size, size);
+    const cv::Point offset = FitOffset(cover_size, size);
+
+    std::vector<FeatureLine> fitted_feature_lines = ResampleFeatureLines(feature_lines, image_size, cover_size);
+
+    for (auto &line : fitted_feature_lines) {
+      line.first -= cv::Point2d(offset);
+      line.second -= cv::Point2d(offset);
+    }
+
+    return fitted_feature_lines;
+  }
+
+  cv::Size CommonFrameSize(const std::vector<cv::Size> &image_sizes) {
+    if (image_sizes.empty()) {
+      return cv::Size();
+    }
+
+    const double aspect_ratio = image_sizes[0].width / (double)image_sizes[0].height;
+
+    int width = image_sizes[0].width;
+    for (const cv::Size &image_size : image_sizes) {
+      width = std::min(width, std::min(image_size.width, (int)(image_size.height * aspect_ratio)));
+    }
+
+    // width / aspect_ratio is at most the height of every image, so rounding it does not go past any of them
+    width = std::max(1, width);
+    return cv::Size(width, std::max(1, (int)std::lround(width / aspect_ratio)));
+  }
+
+}
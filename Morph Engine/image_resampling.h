@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "feature_line.h"
+
+namespace ImageMorphing {
+
+  // Resizes image to size with separable filters: area averaging along the axes it shrinks, which does not alias,
+  // and Lanczos along the axes it enlarges. The aspect ratio follows size, FitImage keeps the one of the image.
+  cv::Mat ResampleImage(const cv::Mat &image, const cv::Size &size);
+
+  // Size an image of image_size is scaled to, keeping its aspect ratio, so it just covers size
+  cv::Size FitCoverSize(const cv::Size &image_size, const cv::Size &size);
+
+  // Scales image uniformly to cover size and crops what sticks out on either side, so images of another aspect ratio
+  // lose a band at their edges rather than getting stretched
+  cv::Mat FitImage(const cv::Mat &image, const cv::Size &size);
+
+  // Lines drawn on an image of image_size, moved onto the image fitted to size by FitImage
+  std::vector<FeatureLine> FitFeatureLines(const FeatureLineSpan &feature_lines, const cv::Size &image_size, const cv::Size &size);
+
+  // Largest frame size with the aspect ratio of the first image that every image covers, so images fitted to it are
+  // never enlarged nor distorted
+  cv::Size CommonFrameSize(const std::vector<cv::Size> &image_sizes);
+
+}
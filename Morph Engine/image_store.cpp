@@ -0,0 +1,98 @@
+#include "image_store.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include <opencv2/imgproc.hpp>
+
+#include "image_resampling.h"
+#include "pixel_format.h"
+
+namespace ImageMorphing {
+
+  struct ImageStore::State {
+
+    std::mutex mutex_;
+
+    // Pyramid of every image, level 0 first
+    std::vector<std::vector<cv::Mat> > pyramids_;
+  };
+
+  ImageStore::ImageStore() : state_(new State()) {
+  }
+
+  ImageStore::~ImageStore() {
+  }
+
+  bool ImageStore::Load(const std::string &file_path, const int type) {
+    cv::Mat image = ReadImage(file_path, type);
+    if (image.empty()) {
+      return false;
+    }
+
+    Add(image);
+    return true;
+  }
+
+  void ImageStore::Add(const cv::Mat &image) {
+    std::lock_guard<std::mutex> lock(state_->mutex_);
+    state_->pyramids_.push_back(std::vector<cv::Mat>(1, image));
+  }
+
+  void ImageStore::Clear() {
+    std::lock_guard<std::mutex> lock(state_->mutex_);
+    state_->pyramids_.clear();
+  }
+
+  size_t ImageStore::ImageCount() const {
+    std::lock_guard<std::mutex> lock(state_->mutex_);
+    return state_->pyramids_.size();
+  }
+
+  cv::Mat ImageStore::Image(const size_t image_index, const size_t level) const {
+    std::lock_guard<std::mutex> lock(state_->mutex_);
+
+    std::vector<cv::Mat> &pyramid = state_->pyramids_[image_index];
+
+    while (pyramid.size() <= level) {
+      const cv::Mat &finest_level = pyramid.back();
+      if (finest_level.cols <= 1 && finest_level.rows <= 1) {
+        return finest_level;
+      }
+
+      cv::Mat next_level;
+      cv::pyrDown(finest_level, next_level);
+      pyramid.push_back(next_level);
+    }
+
+    return pyramid[level];
+  }
+
+  cv::Size ImageStore::CommonSize(const size_t level) const {
+    const size_t image_count = ImageCount();
+
+    std::vector<cv::Size> image_sizes;
+
+    for (size_t image_index = 0; image_index < image_count; ++image_index) {
+      image_sizes.push_back(Image(image_index, level).size());
+    }
+
+    return CommonFrameSize(image_sizes);
+  }
+
+  cv::Mat ImageStore::Resampled(const size_t image_index, const cv::Size &size) const {
+    size_t level = 0;
+    cv::Mat image = Image(image_index);
+
+    // Scaled from the original size, so the crop matches FitFeatureLines whichever level it starts from
+    const cv::Size cover_size = FitCoverSize(image.size(), size);
+
+    // cv::pyrDown halves the size rounding up
+    while ((image.cols + 1) / 2 >= cover_size.width && (image.rows + 1) / 2 >= cover_size.height && (image.cols > 1 || image.rows > 1)) {
+      image = Image(image_index, ++level);
+    }
+
+    return FitImage(ResampleImage(image, cover_size), size);
+  }
+
+}
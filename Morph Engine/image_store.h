@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  // Decoded images, each file decoded once. Besides the original every image has a pyramid of levels, each half the size
+  // of the previous one, built the first time it is asked for. Images are handed out as views of the stored pixels,
+  // never cloned, so they must not be written. Safe to use from several threads.
+  class ImageStore {
+
+  public:
+
+    ImageStore();
+
+    ~ImageStore();
+
+    // Appends the image decoded from file_path as type (see ReadImage), returns false if it cannot be read
+    bool Load(const std::string &file_path, const int type = CV_8UC3);
+
+    void Add(const cv::Mat &image);
+
+    void Clear();
+
+    size_t ImageCount() const;
+
+    // Level 0 is the decoded image. Levels past the one of a single pixel return that one.
+    cv::Mat Image(const size_t image_index, const size_t level = 0) const;
+
+    // CommonFrameSize of the images at level: the aspect ratio of the first image, and no image needs enlarging
+    cv::Size CommonSize(const size_t level = 0) const;
+
+    // Image image_index fitted to size (see FitImage), starting from the smallest pyramid level still covering it
+    cv::Mat Resampled(const size_t image_index, const cv::Size &size) const;
+
+  private:
+
+    ImageStore(const ImageStore &) = delete;
+    ImageStore &operator =(const ImageStore &) = delete;
+
+    // Keeps <mutex> out of the header, which code compiled with /clr cannot include
+    struct State;
+
+    std::unique_ptr<State> state_;
+  };
+
+}
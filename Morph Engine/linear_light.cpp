@@ -0,0 +1,144 @@
+#include "linear_light.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    struct BlendSpaceEntry {
+      BlendSpace blend_space_;
+      const char *name_;
+    };
+
+    const BlendSpaceEntry BLEND_SPACES[] = {
+      { BlendSpace::GAMMA, "gamma" },
+      { BlendSpace::LINEAR_LIGHT, "linear" }
+    };
+
+    // sRGB transfer functions on [0, 1]
+    double SRGBToLinear(const double value) {
+      return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+    }
+
+    double LinearToSRGB(const double value) {
+      return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1 / 2.4) - 0.055;
+    }
+
+    // Linear light in fixed point with 14 fractional bits, enough to tell the darkest 8-bit sRGB values apart
+    const int LINEAR_LIGHT_ONE = 1 << 14;
+
+    // Lookup tables between 8-bit sRGB and linear light in fixed point
+    struct SRGBTables {
+
+      SRGBTables() {
+        for (int value = 0; value < 256; ++value) {
+          decode_[value] = (int)std::lround(SRGBToLinear(value / 255.0) * LINEAR_LIGHT_ONE);
+        }
+
+        for (int value = 0; value <= LINEAR_LIGHT_ONE; ++value) {
+          encode_[value] = (uchar)std::lround(LinearToSRGB(value / (double)LINEAR_LIGHT_ONE) * 255);
+        }
+
+        // The color is divided by its alpha in 8 bits, as an image stored without premultiplication would hold it
+        for (int alpha = 0; alpha < 256; ++alpha) {
+          for (int color = 0; color < 256; ++color) {
+            const int straight_color = alpha ? (std::min(color, alpha) * 255 + alpha / 2) / alpha : 0;
+            decode_premultiplied_[alpha << 8 | color] = (decode_[straight_color] * alpha + 127) / 255;
+          }
+        }
+      }
+
+      int decode_[256];
+      uchar encode_[LINEAR_LIGHT_ONE + 1];
+
+      // Linear light of premultiplied 8-bit colors, premultiplied, indexed by alpha << 8 | color
+      int decode_premultiplied_[256 * 256];
+    };
+
+    // Built with the other globals, so threads blending at the same time never build it twice
+    const SRGBTables SRGB_TABLES;
+
+    // Weights of the blend in fixed point, the same as the ones of the gamma blend so t = 0 and t = 1 give the images back
+    const int BLEND_WEIGHT_BITS = 14;
+
+  }
+
+  bool ParseBlendSpace(const std::string &name, BlendSpace &blend_space) {
+    for (const BlendSpaceEntry &entry : BLEND_SPACES) {
+      if (name == entry.name_) {
+        blend_space = entry.blend_space_;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  LinearLightBlendTable::LinearLightBlendTable() : t_(0), source_weight_(0), destination_weight_(-1) {
+  }
+
+  LinearLightBlendTable::LinearLightBlendTable(const double t) : t_(0), source_weight_(0), destination_weight_(-1) {
+    Update(t);
+  }
+
+  void LinearLightBlendTable::Update(const double t) {
+    const int destination_weight = (int)(t * (1 << BLEND_WEIGHT_BITS) + 0.5);
+    t_ = t;
+
+    if (destination_weight == destination_weight_) {
+      return;
+    }
+
+    destination_weight_ = destination_weight;
+    source_weight_ = (1 << BLEND_WEIGHT_BITS) - destination_weight;
+    colors_.resize(256 * 256);
+
+    const int rounding = 1 << (BLEND_WEIGHT_BITS - 1);
+
+    for (int source = 0; source < 256; ++source) {
+      const int source_term = SRGB_TABLES.decode_[source] * source_weight_ + rounding;
+      uchar *colors = &colors_[source << 8];
+
+      for (int destination = 0; destination < 256; ++destination) {
+        colors[destination] = SRGB_TABLES.encode_[(source_term + SRGB_TABLES.decode_[destination] * destination_weight_) >> BLEND_WEIGHT_BITS];
+      }
+    }
+  }
+
+  void CrossDissolvePremultipliedRowLinearLight(const uchar *source, const uchar *destination, const LinearLightBlendTable &blend_table,
+    uchar *result, const int pixel_count) {
+    // The ends of the transition give the images back as they are, rather than after a round trip through linear light
+    if (blend_table.destination_weight_ <= 0 || blend_table.source_weight_ <= 0) {
+      memcpy(result, blend_table.destination_weight_ <= 0 ? source : destination, pixel_count * 4);
+      return;
+    }
+
+    const int source_weight = blend_table.source_weight_;
+    const int destination_weight = blend_table.destination_weight_;
+    const int rounding = 1 << (BLEND_WEIGHT_BITS - 1);
+
+    for (int i = 0; i < pixel_count * 4; i += 4) {
+      const int alpha = (source[i + 3] * source_weight + destination[i + 3] * destination_weight + rounding) >> BLEND_WEIGHT_BITS;
+      result[i + 3] = (uchar)alpha;
+
+      if (!alpha) {
+        result[i] = result[i + 1] = result[i + 2] = 0;
+        continue;
+      }
+
+      const int *source_colors = &SRGB_TABLES.decode_premultiplied_[source[i + 3] << 8];
+      const int *destination_colors = &SRGB_TABLES.decode_premultiplied_[destination[i + 3] << 8];
+
+      for (int c = 0; c < 3; ++c) {
+        // Premultiplied linear light, weighted by the alpha of each image, then divided by the blended alpha
+        const int color = (source_colors[source[i + c]] * source_weight + destination_colors[destination[i + c]] * destination_weight + rounding) >> BLEND_WEIGHT_BITS;
+        const int straight_color = std::min((color * 255 + alpha / 2) / alpha, LINEAR_LIGHT_ONE);
+        result[i + c] = (uchar)((SRGB_TABLES.encode_[straight_color] * alpha + 127) / 255);
+      }
+    }
+  }
+
+}
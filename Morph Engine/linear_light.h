@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  // Values the cross dissolve blends
+  enum class BlendSpace {
+    // The values of the images as they are stored, gamma encoded for 8-bit images
+    GAMMA,
+    // Light intensities decoded from sRGB, so midtones do not darken halfway through the transition.
+    // Premultiplied colors are divided by their alpha before decoding and blended weighted by it.
+    // Only changes 8-bit images, 16-bit and float images are blended as they are.
+    LINEAR_LIGHT
+  };
+
+  // Sets blend_space to the one called name, "gamma" or "linear". Returns false for unknown names.
+  bool ParseBlendSpace(const std::string &name, BlendSpace &blend_space);
+
+  // Results of cross dissolving every pair of 8-bit values at one t in linear light, indexed by source << 8 | destination.
+  // Composes the sRGB decode table, the blend and the linear to sRGB table into one lookup per channel, so the blend in
+  // linear light stays within a small factor of the one of the stored values. Building it costs as much as blending 64K channels,
+  // so a caller blending many images keeps one table and updates it for every t.
+  struct LinearLightBlendTable {
+
+    // Empty until Update is called
+    LinearLightBlendTable();
+
+    explicit LinearLightBlendTable(const double t);
+
+    // Builds the table for t. Keeps it when t blends with the same weights as the t it was built for, so all the tiles
+    // and images of a frame share one build, and never reallocates it.
+    void Update(const double t);
+
+    double t_;
+
+    // Fixed point weights of the blend, destination_weight_ is -1 while the table is empty
+    int source_weight_;
+    int destination_weight_;
+
+    std::vector<uchar> colors_;
+  };
+
+  // Cross dissolves pixel_count premultiplied 8-bit BGRA pixels in linear light at the t of blend_table.
+  // Colors are divided by their alpha, decoded and blended weighted by it, then premultiplied again, so none exceeds the alpha.
+  void CrossDissolvePremultipliedRowLinearLight(const uchar *source, const uchar *destination, const LinearLightBlendTable &blend_table,
+    uchar *result, const int pixel_count);
+
+}
@@ -0,0 +1,156 @@
+#include "memory_mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ImageMorphing {
+
+  MemoryMappedFile::MemoryMappedFile() : data_(nullptr), size_(0), is_writable_(false) {
+  }
+
+  MemoryMappedFile::~MemoryMappedFile() {
+    Close();
+  }
+
+  bool MemoryMappedFile::Open(const std::string &file_path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || !file_size.QuadPart) {
+      CloseHandle(file);
+      return false;
+    }
+
+    HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!file_mapping) {
+      return false;
+    }
+
+    data_ = (char *)MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(file_mapping);
+    if (!data_) {
+      return false;
+    }
+
+    size_ = (size_t)file_size.QuadPart;
+#else
+    int file = open(file_path.c_str(), O_RDONLY);
+    if (file < 0) {
+      return false;
+    }
+
+    struct stat file_status;
+    if (fstat(file, &file_status) || !file_status.st_size) {
+      close(file);
+      return false;
+    }
+
+    void *data = mmap(nullptr, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    data_ = (char *)data;
+    size_ = (size_t)file_status.st_size;
+#endif
+
+    return true;
+  }
+
+  bool MemoryMappedFile::Create(const std::string &file_path, const size_t size) {
+    Close();
+
+    if (!size) {
+      return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    // The mapping grows the file to its size
+    HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, nullptr);
+    CloseHandle(file);
+    if (!file_mapping) {
+      return false;
+    }
+
+    data_ = (char *)MapViewOfFile(file_mapping, FILE_MAP_WRITE, 0, 0, 0);
+    CloseHandle(file_mapping);
+    if (!data_) {
+      return false;
+    }
+#else
+    int file = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+      return false;
+    }
+
+    if (ftruncate(file, (off_t)size)) {
+      close(file);
+      return false;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    data_ = (char *)data;
+#endif
+
+    size_ = size;
+    is_writable_ = true;
+
+    return true;
+  }
+
+  void MemoryMappedFile::Close() {
+    if (!data_) {
+      return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+    is_writable_ = false;
+  }
+
+  bool MemoryMappedFile::Flush(const size_t offset, const size_t size) {
+    if (!is_writable_ || offset > size_ || size > size_ - offset) {
+      return false;
+    }
+
+#ifdef _WIN32
+    return FlushViewOfFile(data_ + offset, size) != 0;
+#else
+    // msync wants a page aligned start
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t aligned_offset = offset / page_size * page_size;
+    return !msync(data_ + aligned_offset, offset + size - aligned_offset, MS_ASYNC);
+#endif
+  }
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+
+namespace ImageMorphing {
+
+  // Whole file mapped into memory, read-only or read-write. The operating system pages the contents in and out,
+  // so only the parts actually touched take up memory.
+  class MemoryMappedFile {
+
+  public:
+
+    MemoryMappedFile();
+
+    ~MemoryMappedFile();
+
+    bool Open(const std::string &file_path);
+
+    // Creates or truncates the file to size bytes and maps it for writing
+    bool Create(const std::string &file_path, const size_t size);
+
+    void Close();
+
+    // Writes the modified pages of [offset, offset + size) back to the file
+    bool Flush(const size_t offset, const size_t size);
+
+    bool IsOpen() const {
+      return data_ != nullptr;
+    }
+
+    bool IsWritable() const {
+      return is_writable_;
+    }
+
+    const char *data() const {
+      return data_;
+    }
+
+    // nullptr unless the file was created for writing
+    char *writable_data() {
+      return is_writable_ ? data_ : nullptr;
+    }
+
+    size_t size() const {
+      return size_;
+    }
+
+  private:
+
+    MemoryMappedFile(const MemoryMappedFile &) = delete;
+    MemoryMappedFile &operator =(const MemoryMappedFile &) = delete;
+
+    char *data_;
+    size_t size_;
+
+    bool is_writable_;
+  };
+
+}
@@ -0,0 +1,345 @@
+#include "morph_engine.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <omp.h>
+
+#include "morphing.h"
+#include "pixel_format.h"
+#include "profiler.h"
+#include "warping.h"
+
+namespace ImageMorphing {
+
+  MorphEngine::MorphEngine(std::unique_ptr<RenderBackend> render_backend) : render_backend_(std::move(render_backend)), grid_mesh_grid_size_(0) {
+  }
+
+  void MorphEngine::PrepareGridMesh(const cv::Size &image_size) {
+    const size_t grid_size = CappedGridSize(image_size, options_.grid_size_, options_.max_grid_vertex_count_);
+
+    if (grid_mesh_.image_size_ == image_size && grid_mesh_grid_size_ == grid_size) {
+      return;
+    }
+
+    grid_mesh_ = GridMesh(image_size, grid_size);
+    grid_mesh_grid_size_ = grid_size;
+
+    grid_mesh_solver_.SetGridMesh(grid_mesh_);
+  }
+
+  void MorphEngine::OptimizeWarpedGridVertices(const cv::Size &image_size,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    std::vector<glm::vec2> &warped_vertices) {
+
+    PrepareGridMesh(image_size);
+
+    grid_mesh_solver_.SetThreadCount(options_.solver_thread_count_);
+
+    FlipFeatureLines(source_feature_lines, image_size.height, flipped_source_feature_lines_);
+    FlipFeatureLines(destination_feature_lines, image_size.height, flipped_destination_feature_lines_);
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::VERTEX_TARGETS);
+      ComputeWarpedGridTargets(grid_mesh_, flipped_source_feature_lines_, flipped_destination_feature_lines_, options_.a_, options_.b_, options_.p_, target_vertices_);
+    }
+
+    grid_mesh_solver_.Solve(target_vertices_, warped_vertices);
+  }
+
+  cv::Mat MorphEngine::ImageWarpingWithMeshOptimization(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines) {
+
+    OptimizeWarpedGridVertices(source_image.size(), source_feature_lines, destination_feature_lines, warped_vertices_);
+
+    return render_backend_->Render(source_image, grid_mesh_, warped_vertices_, options_.texture_filter_);
+  }
+
+  void MorphEngine::ImageWarpingWithMeshOptimization(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    cv::Mat &warped_image) {
+
+    OptimizeWarpedGridVertices(source_image.size(), source_feature_lines, destination_feature_lines, warped_vertices_);
+
+    render_backend_->Render(source_image, grid_mesh_, warped_vertices_, options_.texture_filter_, warped_image);
+  }
+
+  std::vector<cv::Mat> MorphEngine::ImageWarpingWithMeshOptimizationBatch(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const std::vector<std::vector<FeatureLine> > &destination_feature_lines_batch) {
+    std::vector<cv::Mat> warped_images;
+    ImageWarpingWithMeshOptimizationBatch(source_image, source_feature_lines, destination_feature_lines_batch, warped_images);
+    return warped_images;
+  }
+
+  void MorphEngine::ImageWarpingWithMeshOptimizationBatch(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const std::vector<std::vector<FeatureLine> > &destination_feature_lines_batch,
+    std::vector<cv::Mat> &warped_images) {
+
+    warped_vertices_batch_.resize(destination_feature_lines_batch.size());
+
+    for (size_t i = 0; i < destination_feature_lines_batch.size(); ++i) {
+      OptimizeWarpedGridVertices(source_image.size(), source_feature_lines, destination_feature_lines_batch[i], warped_vertices_batch_[i]);
+    }
+
+    render_backend_->RenderBatch(source_image, grid_mesh_, warped_vertices_batch_, options_.texture_filter_, warped_images);
+  }
+
+  cv::Mat MorphEngine::Morphing(const cv::Mat &source_image, const cv::Mat &destination_image, const double t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines) {
+    if (!CheckMorphingParameters(t, source_feature_lines, destination_feature_lines) || !CheckMorphingImages(source_image, destination_image)) {
+      return source_image;
+    }
+
+    cv::Mat result_image = frame_arena_.Image(source_image.size(), source_image.type());
+    Morphing(source_image, destination_image, t, source_feature_lines, destination_feature_lines, result_image);
+
+    return result_image;
+  }
+
+  void MorphEngine::Morphing(const cv::Mat &source_image, const cv::Mat &destination_image, const double t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    cv::Mat &result_image) {
+    if (!CheckMorphingParameters(t, source_feature_lines, destination_feature_lines) || !CheckMorphingImages(source_image, destination_image)) {
+      source_image.copyTo(result_image);
+      return;
+    }
+
+    MORPH_PROFILE_COUNT(ProfileCounter::MORPHED_FRAMES, 1);
+    MORPH_PROFILE_COUNT(ProfileCounter::INTERPOLATED_FEATURE_LINES, source_feature_lines.size());
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::LINE_INTERPOLATION);
+      FeatureLinesInterpolation(source_feature_lines, destination_feature_lines, t, feature_lines_at_t_);
+    }
+
+    //cv::Mat warped_source_image = ImageWarping(source_image, source_feature_lines, feature_lines_at_t_, options_.a_, options_.b_, options_.p_);
+    cv::Mat warped_source_image = ImageWarpingWithMeshOptimization(source_image, source_feature_lines, feature_lines_at_t_);
+    //cv::Mat warped_destination_image = ImageWarping(destination_image, destination_feature_lines, feature_lines_at_t_, options_.a_, options_.b_, options_.p_);
+    cv::Mat warped_destination_image = ImageWarpingWithMeshOptimization(destination_image, destination_feature_lines, feature_lines_at_t_);
+
+    result_image.create(warped_source_image.size(), warped_source_image.type());
+    BlendWarpedImages(warped_source_image, warped_destination_image, t, result_image);
+  }
+
+  void MorphEngine::OptimizeMotionBlurGridVertices(const cv::Size &image_size, const FeatureLineSpan &feature_lines) {
+    OptimizeWarpedGridVertices(image_size, feature_lines, feature_lines_at_ts_.front(), shutter_open_vertices_);
+    OptimizeWarpedGridVertices(image_size, feature_lines, feature_lines_at_ts_.back(), shutter_close_vertices_);
+
+    const double shutter_t = sub_frame_ts_.back() - sub_frame_ts_.front();
+
+    warped_vertices_batch_.resize(sub_frame_ts_.size());
+
+    // Both solutions satisfy the linear constraints of the solver, so every blend of them does too and no cell flips
+    for (size_t i = 0; i < sub_frame_ts_.size(); ++i) {
+      const float s = shutter_t > 0 ? (float)((sub_frame_ts_[i] - sub_frame_ts_.front()) / shutter_t) : 0.0f;
+
+      warped_vertices_batch_[i].resize(shutter_open_vertices_.size());
+
+      for (size_t vertex_index = 0; vertex_index < shutter_open_vertices_.size(); ++vertex_index) {
+        warped_vertices_batch_[i][vertex_index] = glm::mix(shutter_open_vertices_[vertex_index], shutter_close_vertices_[vertex_index], s);
+      }
+    }
+  }
+
+  void MorphEngine::BlendWarpedImages(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const double t, cv::Mat &result_image) {
+    if (options_.blend_space_ != BlendSpace::LINEAR_LIGHT) {
+      CrossDissolve(warped_source_image, warped_destination_image, t, result_image);
+      return;
+    }
+
+    linear_light_blend_table_.Update(t);
+    CrossDissolve(warped_source_image, warped_destination_image, linear_light_blend_table_, result_image);
+  }
+
+  cv::Mat MorphEngine::MorphingMotionBlur(const cv::Mat &source_image, const cv::Mat &destination_image, const double t, const double shutter_t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines) {
+    if (!CheckMorphingParameters(t, source_feature_lines, destination_feature_lines) || !CheckMorphingImages(source_image, destination_image)) {
+      return source_image;
+    }
+
+    cv::Mat result_image = frame_arena_.Image(source_image.size(), source_image.type());
+    MorphingMotionBlur(source_image, destination_image, t, shutter_t, source_feature_lines, destination_feature_lines, result_image);
+    return result_image;
+  }
+
+  void MorphEngine::MorphingMotionBlur(const cv::Mat &source_image, const cv::Mat &destination_image, const double t, const double shutter_t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    cv::Mat &result_image) {
+    const size_t sub_frame_count = options_.motion_blur_sub_frame_count_;
+
+    if (sub_frame_count <= 1 || shutter_t <= 0) {
+      Morphing(source_image, destination_image, t, source_feature_lines, destination_feature_lines, result_image);
+      return;
+    }
+
+    if (!CheckMorphingParameters(t, source_feature_lines, destination_feature_lines) || !CheckMorphingImages(source_image, destination_image)) {
+      source_image.copyTo(result_image);
+      return;
+    }
+
+    MORPH_PROFILE_COUNT(ProfileCounter::MORPHED_FRAMES, 1);
+    MORPH_PROFILE_COUNT(ProfileCounter::INTERPOLATED_FEATURE_LINES, 2 * source_feature_lines.size());
+
+    sub_frame_ts_.clear();
+
+    for (size_t i = 0; i < sub_frame_count; ++i) {
+      sub_frame_ts_.push_back(std::min(std::max(t + shutter_t * ((i + 0.5) / sub_frame_count - 0.5), 0.0), 1.0));
+    }
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::LINE_INTERPOLATION);
+
+      feature_lines_at_ts_.resize(2);
+      FeatureLinesInterpolation(source_feature_lines, destination_feature_lines, sub_frame_ts_.front(), feature_lines_at_ts_.front());
+      FeatureLinesInterpolation(source_feature_lines, destination_feature_lines, sub_frame_ts_.back(), feature_lines_at_ts_.back());
+    }
+
+    OptimizeMotionBlurGridVertices(source_image.size(), source_feature_lines);
+    render_backend_->RenderBatch(source_image, grid_mesh_, warped_vertices_batch_, options_.texture_filter_, warped_source_images_);
+
+    OptimizeMotionBlurGridVertices(destination_image.size(), destination_feature_lines);
+    render_backend_->RenderBatch(destination_image, grid_mesh_, warped_vertices_batch_, options_.texture_filter_, warped_destination_images_);
+
+    // Sub-frames are summed in float, so none of them is rounded before the average
+    cv::Mat sub_frame = frame_arena_.Image(source_image.size(), source_image.type());
+    cv::Mat sub_frame_sum = frame_arena_.Zeros(source_image.size(), CV_MAKETYPE(CV_32F, source_image.channels()));
+
+    for (size_t i = 0; i < sub_frame_count; ++i) {
+      BlendWarpedImages(warped_source_images_[i], warped_destination_images_[i], sub_frame_ts_[i], sub_frame);
+
+      MORPH_PROFILE_SCOPE(ProfileStage::BLEND);
+      cv::add(sub_frame_sum, sub_frame, sub_frame_sum, cv::noArray(), CV_32F);
+    }
+
+    warped_source_images_.clear();
+    warped_destination_images_.clear();
+
+    result_image.create(source_image.size(), source_image.type());
+
+    MORPH_PROFILE_SCOPE(ProfileStage::BLEND);
+    sub_frame_sum.convertTo(result_image, source_image.type(), 1.0 / sub_frame_count);
+  }
+
+  std::vector<cv::Mat> MorphEngine::MorphingBatch(const cv::Mat &source_image, const cv::Mat &destination_image, const std::vector<double> &ts,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines) {
+    std::vector<cv::Mat> result_images;
+    MorphingBatch(source_image, destination_image, ts, source_feature_lines, destination_feature_lines, result_images);
+    return result_images;
+  }
+
+  void MorphEngine::MorphingBatch(const cv::Mat &source_image, const cv::Mat &destination_image, const std::vector<double> &ts,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    std::vector<cv::Mat> &result_images) {
+    result_images.clear();
+
+    for (const double t : ts) {
+      if (!CheckMorphingParameters(t, source_feature_lines, destination_feature_lines) || !CheckMorphingImages(source_image, destination_image)) {
+        result_images.assign(ts.size(), source_image);
+        return;
+      }
+    }
+
+    MORPH_PROFILE_COUNT(ProfileCounter::MORPHED_FRAMES, ts.size());
+    MORPH_PROFILE_COUNT(ProfileCounter::INTERPOLATED_FEATURE_LINES, ts.size() * source_feature_lines.size());
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::LINE_INTERPOLATION);
+
+      feature_lines_at_ts_.resize(ts.size());
+
+      for (size_t i = 0; i < ts.size(); ++i) {
+        FeatureLinesInterpolation(source_feature_lines, destination_feature_lines, ts[i], feature_lines_at_ts_[i]);
+      }
+    }
+
+    ImageWarpingWithMeshOptimizationBatch(source_image, source_feature_lines, feature_lines_at_ts_, warped_source_images_);
+    ImageWarpingWithMeshOptimizationBatch(destination_image, destination_feature_lines, feature_lines_at_ts_, warped_destination_images_);
+
+    for (size_t i = 0; i < ts.size(); ++i) {
+      result_images.push_back(frame_arena_.Image(warped_source_images_[i].size(), warped_source_images_[i].type()));
+      BlendWarpedImages(warped_source_images_[i], warped_destination_images_[i], ts[i], result_images.back());
+    }
+
+    warped_source_images_.clear();
+    warped_destination_images_.clear();
+  }
+
+  bool MorphEngine::MorphingTiled(const MappedRawImage &source_image, const MappedRawImage &destination_image, const double t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    MappedRawImage &result_image, const int tile_size) {
+    if (!CheckMorphingParameters(t, source_feature_lines, destination_feature_lines)) {
+      return false;
+    }
+
+    const cv::Size image_size = source_image.size();
+
+    if (destination_image.size() != image_size || result_image.size() != image_size ||
+      destination_image.type() != source_image.type() || result_image.type() != source_image.type() ||
+      !IsSupportedImageType(source_image.type()) || tile_size <= 0) {
+      std::cerr << "Tiled morphing needs images of the same size and of the same supported type\n";
+      return false;
+    }
+
+    MORPH_PROFILE_COUNT(ProfileCounter::MORPHED_FRAMES, 1);
+    MORPH_PROFILE_COUNT(ProfileCounter::INTERPOLATED_FEATURE_LINES, source_feature_lines.size());
+
+    {
+      MORPH_PROFILE_SCOPE(ProfileStage::LINE_INTERPOLATION);
+      FeatureLinesInterpolation(source_feature_lines, destination_feature_lines, t, feature_lines_at_t_);
+    }
+
+    std::vector<glm::vec2> warped_source_vertices;
+    std::vector<glm::vec2> warped_destination_vertices;
+    OptimizeWarpedGridVertices(image_size, source_feature_lines, feature_lines_at_t_, warped_source_vertices);
+    OptimizeWarpedGridVertices(image_size, destination_feature_lines, feature_lines_at_t_, warped_destination_vertices);
+
+    // Both warps use the same tiles, only the source parts they need differ
+    std::vector<WarpTile> source_tiles = ComputeWarpTiles(grid_mesh_, warped_source_vertices, tile_size);
+    std::vector<WarpTile> destination_tiles = ComputeWarpTiles(grid_mesh_, warped_destination_vertices, tile_size);
+
+    // Updated once here, the tiles only read it
+    const bool is_linear_light = options_.blend_space_ == BlendSpace::LINEAR_LIGHT;
+    if (is_linear_light) {
+      linear_light_blend_table_.Update(t);
+    }
+
+    int unflushed_tile_count = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:unflushed_tile_count)
+    for (int tile_index = 0; tile_index < (int)source_tiles.size(); ++tile_index) {
+      const WarpTile &source_tile = source_tiles[tile_index];
+      const WarpTile &destination_tile = destination_tiles[tile_index];
+
+      cv::Mat warped_source_tile = RenderWarpTile(source_image.Region(source_tile.source_rect_), grid_mesh_, warped_source_vertices, source_tile, options_.texture_filter_);
+      cv::Mat warped_destination_tile = RenderWarpTile(destination_image.Region(destination_tile.source_rect_), grid_mesh_, warped_destination_vertices, destination_tile, options_.texture_filter_);
+
+      // Blended straight into the mapped result
+      cv::Mat result_tile = result_image.Region(source_tile.rect_);
+      if (is_linear_light) {
+        CrossDissolve(warped_source_tile, warped_destination_tile, linear_light_blend_table_, result_tile);
+      } else {
+        CrossDissolve(warped_source_tile, warped_destination_tile, t, result_tile);
+      }
+
+      // Hands the finished rows to the OS now rather than keeping them dirty in memory
+      if (!result_image.Flush(source_tile.rect_)) {
+        ++unflushed_tile_count;
+      }
+    }
+
+    return !unflushed_tile_count;
+  }
+
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "feature_line.h"
+#include "frame_arena.h"
+#include "grid_mesh.h"
+#include "grid_mesh_solver.h"
+#include "linear_light.h"
+#include "raw_image_file.h"
+#include "render_backend.h"
+#include "texture_filter.h"
+#include "tiled_warping.h"
+
+namespace ImageMorphing {
+
+  const size_t MESH_GRID_SIZE = 20;
+
+  // Vertices of the mesh of a tiled morph, about a 512 x 512 grid, so its solve fits in memory whatever the image size
+  const size_t DEFAULT_TILED_MAX_GRID_VERTEX_COUNT = 1 << 18;
+
+  // Number of frames rendered together by MorphingBatch
+  const size_t MORPHING_BATCH_SIZE = 8;
+
+  const TextureFilter DEFAULT_WARPING_TEXTURE_FILTER = TextureFilter::TRILINEAR;
+
+  // Fraction of the time between two frames the shutter of motion blurred frames stays open, as with a 180 degree shutter
+  const double DEFAULT_MOTION_BLUR_SHUTTER = 0.5;
+
+  struct MorphOptions {
+
+    MorphOptions() : a_(1), b_(2), p_(0), grid_size_(MESH_GRID_SIZE), max_grid_vertex_count_(0), texture_filter_(DEFAULT_WARPING_TEXTURE_FILTER), solver_thread_count_(0),
+      blend_space_(BlendSpace::GAMMA), motion_blur_sub_frame_count_(1), motion_blur_shutter_(DEFAULT_MOTION_BLUR_SHUTTER) {
+    }
+
+    // Weights of the feature lines in [1]
+    double a_;
+    double b_;
+    double p_;
+
+    size_t grid_size_;
+
+    // Images whose mesh would have more vertices get a coarser grid than grid_size_ (see CappedGridSize), 0 for no limit
+    size_t max_grid_vertex_count_;
+
+    TextureFilter texture_filter_;
+
+    // Threads CPLEX may use for one solve, 0 lets CPLEX decide. The pixel loops follow the OpenMP settings of the calling thread.
+    size_t solver_thread_count_;
+
+    // Values the two warped images are cross dissolved in
+    BlendSpace blend_space_;
+
+    // Frames averaged into every motion blurred frame, 1 for sharp frames
+    size_t motion_blur_sub_frame_count_;
+
+    // Fraction of the t between two frames of a sequence the sub-frames are spread over
+    double motion_blur_shutter_;
+  };
+
+  // Everything one morph needs besides its inputs: the render backend, the solver and the grid it is set up for.
+  // Engines share no state, so several of them can run at the same time as long as each one is used by one thread at a time.
+  class MorphEngine {
+
+  public:
+
+    explicit MorphEngine(std::unique_ptr<RenderBackend> render_backend);
+
+    cv::Mat ImageWarpingWithMeshOptimization(const cv::Mat &source_image,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines);
+
+    // Same as above, rendering into warped_image. It is only reallocated when its size or type differ from source_image,
+    // so it may be a buffer of the caller reused from frame to frame, or a cv::Mat header over memory of the caller with any row step.
+    void ImageWarpingWithMeshOptimization(const cv::Mat &source_image,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      cv::Mat &warped_image);
+
+    // Warps source_image towards every line set of destination_feature_lines_batch, rendering all of them in one batch
+    std::vector<cv::Mat> ImageWarpingWithMeshOptimizationBatch(const cv::Mat &source_image,
+      const FeatureLineSpan &source_feature_lines,
+      const std::vector<std::vector<FeatureLine> > &destination_feature_lines_batch);
+
+    // Same as above, replacing the images of warped_images, which keeps its capacity from batch to batch
+    void ImageWarpingWithMeshOptimizationBatch(const cv::Mat &source_image,
+      const FeatureLineSpan &source_feature_lines,
+      const std::vector<std::vector<FeatureLine> > &destination_feature_lines_batch,
+      std::vector<cv::Mat> &warped_images);
+
+    // The frames returned by Morphing and MorphingBatch wrap buffers of the engine, which are reused once every copy of them is released
+    cv::Mat Morphing(const cv::Mat &source_image, const cv::Mat &destination_image, const double t,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines);
+
+    // Same as above, blending into result_image, which is only reallocated when its size or type differ from source_image.
+    // Lets an application morph straight into a buffer it displays or encodes, without copying the frame out of the engine.
+    void Morphing(const cv::Mat &source_image, const cv::Mat &destination_image, const double t,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      cv::Mat &result_image);
+
+    // Motion blurred frame at t: the average of options_.motion_blur_sub_frame_count_ frames spread evenly over
+    // [t - shutter_t / 2, t + shutter_t / 2], clamped to [0, 1]. The lines are interpolated and the meshes solved at the first
+    // and the last sub-frame only, the sub-frames between them get vertices interpolated from those two solutions,
+    // and all sub-frames of an image are rendered in one batch. A sub-frame costs a render and a blend rather than a frame.
+    cv::Mat MorphingMotionBlur(const cv::Mat &source_image, const cv::Mat &destination_image, const double t, const double shutter_t,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines);
+
+    // Same as above, blending into result_image, which is only reallocated when its size or type differ from source_image
+    void MorphingMotionBlur(const cv::Mat &source_image, const cv::Mat &destination_image, const double t, const double shutter_t,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      cv::Mat &result_image);
+
+    // Same as calling Morphing for every value of ts, but the warped meshes of each image are rendered in one batch
+    std::vector<cv::Mat> MorphingBatch(const cv::Mat &source_image, const cv::Mat &destination_image, const std::vector<double> &ts,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines);
+
+    // Same as above, replacing the frames of result_images, which keeps its capacity from batch to batch
+    void MorphingBatch(const cv::Mat &source_image, const cv::Mat &destination_image, const std::vector<double> &ts,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      std::vector<cv::Mat> &result_images);
+
+    // Morphs images too large for memory one output tile at a time, on the CPU whatever the render backend is.
+    // Each tile only reads the parts of both sources its warped triangles sample, and is written to result_image when done,
+    // so the pixels held in memory grow with tile_size rather than with the image. The mesh is still solved over the whole image,
+    // its memory grows with the image unless options_.max_grid_vertex_count_ caps it. result_image must be writable and of the same size.
+    bool MorphingTiled(const MappedRawImage &source_image, const MappedRawImage &destination_image, const double t,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      MappedRawImage &result_image, const int tile_size = DEFAULT_WARP_TILE_SIZE);
+
+    MorphOptions options_;
+
+  private:
+
+    MorphEngine(const MorphEngine &) = delete;
+    MorphEngine &operator =(const MorphEngine &) = delete;
+
+    // Rebuilds the grid mesh and the solver only when the image size or the grid size changed
+    void PrepareGridMesh(const cv::Size &image_size);
+
+    void OptimizeWarpedGridVertices(const cv::Size &image_size,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      std::vector<glm::vec2> &warped_vertices);
+
+    // Fills warped_vertices_batch_ with the vertices of image_size warped towards the lines at every sub_frame_ts_,
+    // from solves at the first and the last of them
+    void OptimizeMotionBlurGridVertices(const cv::Size &image_size, const FeatureLineSpan &feature_lines);
+
+    // Cross dissolves in options_.blend_space_, in linear light with linear_light_blend_table_ updated for t
+    void BlendWarpedImages(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const double t, cv::Mat &result_image);
+
+    std::unique_ptr<RenderBackend> render_backend_;
+
+    GridMesh grid_mesh_;
+    // Grid size the mesh was built with, after capping its vertices
+    size_t grid_mesh_grid_size_;
+
+    GridMeshSolver grid_mesh_solver_;
+
+    // Scratch data of one frame, kept with its capacity so frames after the first allocate none of it
+    std::vector<FeatureLine> feature_lines_at_t_;
+    std::vector<std::vector<FeatureLine> > feature_lines_at_ts_;
+    std::vector<FeatureLine> flipped_source_feature_lines_;
+    std::vector<FeatureLine> flipped_destination_feature_lines_;
+    std::vector<glm::vec2> target_vertices_;
+    std::vector<glm::vec2> warped_vertices_;
+    std::vector<std::vector<glm::vec2> > warped_vertices_batch_;
+    std::vector<double> sub_frame_ts_;
+    std::vector<glm::vec2> shutter_open_vertices_;
+    std::vector<glm::vec2> shutter_close_vertices_;
+    LinearLightBlendTable linear_light_blend_table_;
+
+    // Warped images of a batch, emptied once blended so their buffers go back to the backend
+    std::vector<cv::Mat> warped_source_images_;
+    std::vector<cv::Mat> warped_destination_images_;
+
+    // Result frames
+    FrameArena frame_arena_;
+  };
+
+}
@@ -0,0 +1,64 @@
+#include "morph_sequence.h"
+
+#include <algorithm>
+
+namespace ImageMorphing {
+
+  cv::Size PreviewFrameSize(const cv::Size &frame_size, const size_t preview_level) {
+    return cv::Size(std::max(1, frame_size.width >> preview_level), std::max(1, frame_size.height >> preview_level));
+  }
+
+  void PadFeatureLines(std::vector<std::vector<FeatureLine> > &feature_lines_of_images) {
+    if (feature_lines_of_images.empty()) {
+      return;
+    }
+
+    size_t max_amount_index = 0;
+
+    for (size_t i = 1; i < feature_lines_of_images.size(); ++i) {
+      if (feature_lines_of_images[i].size() > feature_lines_of_images[max_amount_index].size()) {
+        max_amount_index = i;
+      }
+    }
+
+    const std::vector<FeatureLine> max_amount_feature_lines = feature_lines_of_images[max_amount_index];
+
+    for (auto &feature_lines : feature_lines_of_images) {
+      for (size_t i = feature_lines.size(); i < max_amount_feature_lines.size(); ++i) {
+        feature_lines.push_back(max_amount_feature_lines[i]);
+      }
+    }
+  }
+
+  std::vector<MorphFrame> MorphSequenceFrames(const size_t image_count, const size_t frame_count) {
+    std::vector<MorphFrame> frames;
+
+    if (image_count < 2 || !frame_count) {
+      return frames;
+    }
+
+    const double t_gap = 1.0 / (double)frame_count;
+
+    for (size_t segment_index = 0; segment_index + 1 < image_count; ++segment_index) {
+      for (size_t frame_index = !!segment_index; frame_index <= frame_count; ++frame_index) {
+        frames.push_back(MorphFrame(segment_index, t_gap * frame_index));
+      }
+    }
+
+    return frames;
+  }
+
+  std::vector<std::vector<MorphFrame> > BatchMorphFrames(const std::vector<MorphFrame> &frames, const size_t batch_size) {
+    std::vector<std::vector<MorphFrame> > batches;
+
+    for (const auto &frame : frames) {
+      if (batches.empty() || batches.back().size() >= batch_size || batches.back().back().segment_index_ != frame.segment_index_) {
+        batches.push_back(std::vector<MorphFrame>());
+      }
+      batches.back().push_back(frame);
+    }
+
+    return batches;
+  }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "feature_line.h"
+
+namespace ImageMorphing {
+
+  // One frame of a sequence morphing image segment_index_ into image segment_index_ + 1
+  struct MorphFrame {
+
+    MorphFrame() : segment_index_(0), t_(0) {
+    }
+
+    MorphFrame(const size_t segment_index, const double t) : segment_index_(segment_index), t_(t) {
+    }
+
+    size_t segment_index_;
+    double t_;
+  };
+
+  // Preview frames are 2^DEFAULT_PREVIEW_LEVEL times smaller than the frames along each axis
+  const size_t DEFAULT_PREVIEW_LEVEL = 2;
+
+  // Size of the frames of a preview 2^preview_level times smaller than frame_size, never empty
+  cv::Size PreviewFrameSize(const cv::Size &frame_size, const size_t preview_level);
+
+  // Images with fewer feature lines than the others borrow the missing ones from the image with the most lines
+  void PadFeatureLines(std::vector<std::vector<FeatureLine> > &feature_lines_of_images);
+
+  // Frames of a sequence through image_count images with frame_count + 1 frames per segment.
+  // Every segment but the first skips t = 0, which is the last frame of the previous segment.
+  std::vector<MorphFrame> MorphSequenceFrames(const size_t image_count, const size_t frame_count);
+
+  // Splits frames into runs of at most batch_size consecutive frames of the same segment, ready for MorphEngine::MorphingBatch
+  std::vector<std::vector<MorphFrame> > BatchMorphFrames(const std::vector<MorphFrame> &frames, const size_t batch_size);
+
+}
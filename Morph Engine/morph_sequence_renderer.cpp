@@ -0,0 +1,230 @@
+#include "morph_sequence_renderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <omp.h>
+
+#include "image_resampling.h"
+#include "morphing.h"
+#include "profiler.h"
+
+namespace ImageMorphing {
+
+  namespace {
+
+    // Thrown by the jobs of a canceled render, so the frame pipeline stops and joins its threads
+    struct RenderCanceled {
+    };
+
+    // Span of t the shutter of a motion blurred frame stays open, frames of a segment are 1 / frame_count apart
+    double MotionBlurShutterT(const MorphOptions &options, const size_t frame_count) {
+      return options.motion_blur_sub_frame_count_ > 1 && frame_count ? options.motion_blur_shutter_ / frame_count : 0;
+    }
+
+    // Whether the engine can morph the resampled pair at every t
+    bool IsMorphablePair(const MorphPair &morph_pair, const std::vector<double> &ts) {
+      for (const double t : ts) {
+        if (!CheckMorphingParameters(t, morph_pair.source_feature_lines_, morph_pair.destination_feature_lines_)) {
+          return false;
+        }
+      }
+
+      return CheckMorphingImages(morph_pair.source_image_, morph_pair.destination_image_);
+    }
+
+  }
+
+  struct MorphSequenceRenderer::CancelState {
+
+    CancelState() : is_canceled_(false) {
+    }
+
+    std::atomic<bool> is_canceled_;
+  };
+
+  SequenceThreading ScheduleSequenceThreading(const size_t thread_count, const size_t frame_count) {
+    SequenceThreading threading;
+
+    threading.worker_count_ = std::max<size_t>(1, std::min(thread_count, frame_count));
+    threading.thread_count_per_worker_ = std::max<size_t>(1, thread_count / threading.worker_count_);
+
+    return threading;
+  }
+
+  MorphSequenceRenderer::MorphSequenceRenderer(const RenderBackendFactory &render_backend_factory, const size_t thread_count)
+    : thread_count_(thread_count), max_resident_images_(0), render_backend_factory_(render_backend_factory), cancel_state_(new CancelState()) {
+  }
+
+  MorphSequenceRenderer::~MorphSequenceRenderer() {
+  }
+
+  void MorphSequenceRenderer::Cancel() {
+    cancel_state_->is_canceled_ = true;
+  }
+
+  bool MorphSequenceRenderer::IsCanceled() const {
+    return cancel_state_->is_canceled_;
+  }
+
+  void MorphSequenceRenderer::Render(const std::vector<cv::Mat> &images, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+    const size_t frame_count, const FramePipeline::ConsumeFunction &consume) {
+    // Every image is already in memory, there is nothing to bound
+    SequenceImageCache image_cache(images.size(), [&](const size_t image_index) {
+      return images[image_index];
+    }, 0);
+
+    RenderFrames(image_cache, MorphSequenceFrames(images.size(), frame_count), MotionBlurShutterT(options_, frame_count), feature_lines_of_images, consume);
+  }
+
+  void MorphSequenceRenderer::Render(const size_t image_count, const SequenceImageCache::LoadFunction &load_image, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+    const size_t frame_count, const FramePipeline::ConsumeFunction &consume) {
+    SequenceImageCache image_cache(image_count, load_image, max_resident_images_);
+
+    RenderFrames(image_cache, MorphSequenceFrames(image_count, frame_count), MotionBlurShutterT(options_, frame_count), feature_lines_of_images, consume);
+  }
+
+  void MorphSequenceRenderer::RenderProgressive(const size_t image_count, const SequenceImageCache::LoadFunction &load_image, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+    const size_t frame_count, const cv::Size &frame_size, const size_t preview_level,
+    const FramePipeline::ConsumeFunction &consume_preview, const FramePipeline::ConsumeFunction &consume) {
+    const cv::Size preview_frame_size = PreviewFrameSize(frame_size, preview_level);
+
+    std::vector<std::vector<FeatureLine> > preview_feature_lines_of_images;
+    for (const auto &feature_lines : feature_lines_of_images) {
+      preview_feature_lines_of_images.push_back(ResampleFeatureLines(feature_lines, frame_size, preview_frame_size));
+    }
+
+    {
+      SequenceImageCache preview_image_cache(image_count, [&](const size_t image_index) {
+        return ResampleImage(load_image(image_index), preview_frame_size);
+      }, max_resident_images_);
+
+      // Previews stay sharp, they are for checking the timing
+      RenderFrames(preview_image_cache, MorphSequenceFrames(image_count, frame_count), 0,
+        std::vector<FeatureLineSpan>(preview_feature_lines_of_images.begin(), preview_feature_lines_of_images.end()), consume_preview);
+    }
+
+    Render(image_count, load_image, feature_lines_of_images, frame_count, consume);
+  }
+
+  void MorphSequenceRenderer::RenderPairs(const size_t pair_count, const PairLoadFunction &load_pair, const std::vector<double> &ts, const cv::Size &frame_size,
+    const PairConsumeFunction &consume) {
+    if (!pair_count || ts.empty() || IsCanceled()) {
+      return;
+    }
+
+    PrepareWorkers(pair_count);
+
+    const int thread_count_per_worker = (int)threading_.thread_count_per_worker_;
+    const int calling_thread_max_threads = omp_get_max_threads();
+
+    FramePipeline frame_pipeline(threading_.worker_count_);
+
+    size_t consumed_frame_count = 0;
+
+    // One job per pair, its frames are rendered in one batch
+    try {
+      frame_pipeline.Run(pair_count, [&](const size_t pair_index, const size_t worker_index, std::vector<cv::Mat> &frames) {
+        if (IsCanceled()) {
+          throw RenderCanceled();
+        }
+
+        omp_set_num_threads(thread_count_per_worker);
+
+        MORPH_PROFILE_FRAME(pair_index);
+
+        MorphPair morph_pair = load_pair(pair_index);
+
+        // A pair that failed to load or cannot be morphed still hands over ts.size() frames, all empty
+        if (morph_pair.source_image_.empty() || morph_pair.destination_image_.empty()) {
+          frames.assign(ts.size(), cv::Mat());
+          return;
+        }
+
+        if (morph_pair.source_image_.size() != frame_size) {
+          morph_pair.source_feature_lines_ = FitFeatureLines(morph_pair.source_feature_lines_, morph_pair.source_image_.size(), frame_size);
+          morph_pair.source_image_ = FitImage(morph_pair.source_image_, frame_size);
+        }
+
+        if (morph_pair.destination_image_.size() != frame_size) {
+          morph_pair.destination_feature_lines_ = FitFeatureLines(morph_pair.destination_feature_lines_, morph_pair.destination_image_.size(), frame_size);
+          morph_pair.destination_image_ = FitImage(morph_pair.destination_image_, frame_size);
+        }
+
+        if (!IsMorphablePair(morph_pair, ts)) {
+          frames.assign(ts.size(), cv::Mat());
+          return;
+        }
+
+        morph_engines_[worker_index]->MorphingBatch(morph_pair.source_image_, morph_pair.destination_image_, ts,
+          morph_pair.source_feature_lines_, morph_pair.destination_feature_lines_, frames);
+      }, [&](const cv::Mat &frame) {
+        // Every job hands over exactly ts.size() frames, in order
+        consume(consumed_frame_count / ts.size(), consumed_frame_count % ts.size(), frame);
+        ++consumed_frame_count;
+      });
+    } catch (const RenderCanceled &) {
+    }
+
+    omp_set_num_threads(calling_thread_max_threads);
+  }
+
+  void MorphSequenceRenderer::PrepareWorkers(const size_t job_count) {
+    const size_t thread_count = thread_count_ ? thread_count_ : std::max<unsigned int>(1, std::thread::hardware_concurrency());
+
+    threading_ = ScheduleSequenceThreading(thread_count, job_count);
+
+    while (morph_engines_.size() < threading_.worker_count_) {
+      morph_engines_.push_back(std::unique_ptr<MorphEngine>(new MorphEngine(render_backend_factory_())));
+    }
+
+    for (auto &morph_engine : morph_engines_) {
+      morph_engine->options_ = options_;
+      morph_engine->options_.solver_thread_count_ = threading_.thread_count_per_worker_;
+    }
+  }
+
+  void MorphSequenceRenderer::RenderFrames(SequenceImageCache &image_cache, const std::vector<MorphFrame> &frames, const double shutter_t,
+    const std::vector<FeatureLineSpan> &feature_lines_of_images,
+    const FramePipeline::ConsumeFunction &consume) {
+    if (IsCanceled()) {
+      return;
+    }
+
+    PrepareWorkers(frames.size());
+
+    const int thread_count_per_worker = (int)threading_.thread_count_per_worker_;
+
+    // The calling thread is worker 0, its OpenMP thread count is restored afterwards
+    const int calling_thread_max_threads = omp_get_max_threads();
+
+    FramePipeline frame_pipeline(threading_.worker_count_);
+
+    // One job per frame, so short clips still spread over every worker
+    try {
+      frame_pipeline.Run(frames.size(), [&](const size_t frame_index, const size_t worker_index, std::vector<cv::Mat> &frames_at_t) {
+        if (IsCanceled()) {
+          throw RenderCanceled();
+        }
+
+        // The OpenMP thread count is per thread, this only affects the loops run by this worker
+        omp_set_num_threads(thread_count_per_worker);
+
+        MORPH_PROFILE_FRAME(frame_index);
+
+        const MorphFrame &frame = frames[frame_index];
+        const size_t segment_index = frame.segment_index_;
+
+        const AcquiredSegment segment(image_cache, segment_index);
+
+        frames_at_t.push_back(morph_engines_[worker_index]->MorphingMotionBlur(segment.source_image_, segment.destination_image_, frame.t_, shutter_t,
+          feature_lines_of_images[segment_index], feature_lines_of_images[segment_index + 1]));
+      }, consume);
+    } catch (const RenderCanceled &) {
+    }
+
+    omp_set_num_threads(calling_thread_max_threads);
+  }
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "feature_line.h"
+#include "frame_pipeline.h"
+#include "morph_engine.h"
+#include "morph_sequence.h"
+#include "render_backend.h"
+#include "sequence_image_cache.h"
+
+namespace ImageMorphing {
+
+  typedef std::function<std::unique_ptr<RenderBackend>()> RenderBackendFactory;
+
+  // Two images to morph into each other, with lines of the same template (same count, same order) on both
+  struct MorphPair {
+    cv::Mat source_image_;
+    cv::Mat destination_image_;
+    std::vector<FeatureLine> source_feature_lines_;
+    std::vector<FeatureLine> destination_feature_lines_;
+  };
+
+  // How the threads of a sequence are split: whole frames run side by side on worker_count_ workers,
+  // and every frame may use thread_count_per_worker_ threads for its own pixel loops and solves
+  struct SequenceThreading {
+
+    SequenceThreading() : worker_count_(1), thread_count_per_worker_(1) {
+    }
+
+    size_t worker_count_;
+    size_t thread_count_per_worker_;
+  };
+
+  // Frames are independent, so as many frames as there are threads run at once.
+  // Nested parallelism inside a frame only gets the threads left over when there are fewer frames than threads.
+  SequenceThreading ScheduleSequenceThreading(const size_t thread_count, const size_t frame_count);
+
+  // Renders whole morph sequences with one engine per worker. The backends come from render_backend_factory,
+  // which must create backends usable from any thread (e.g. CPURenderBackend).
+  class MorphSequenceRenderer {
+
+  public:
+
+    // A thread_count of 0 uses every hardware thread
+    explicit MorphSequenceRenderer(const RenderBackendFactory &render_backend_factory, const size_t thread_count = 0);
+
+    ~MorphSequenceRenderer();
+
+    // Morphs through images with frame_count + 1 frames per segment (see MorphSequenceFrames).
+    // consume receives the frames in order, on a thread of its own, while the next frames are computed.
+    // With options_.motion_blur_sub_frame_count_ above 1 every frame is motion blurred over options_.motion_blur_shutter_ of a frame.
+    void Render(const std::vector<cv::Mat> &images, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+      const size_t frame_count, const FramePipeline::ConsumeFunction &consume);
+
+    // Same as above, but the images are loaded on demand by load_image and at most max_resident_images_ of them are kept in memory.
+    // Frames of every segment are scheduled together, so the segments of a long chain are morphed concurrently.
+    void Render(const size_t image_count, const SequenceImageCache::LoadFunction &load_image, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+      const size_t frame_count, const FramePipeline::ConsumeFunction &consume);
+
+    // Renders the whole sequence twice: first at PreviewFrameSize(frame_size, preview_level), handing every preview frame
+    // to consume_preview as soon as it is done, then at full size to consume. The grid size stays in pixels, so previews
+    // also solve a mesh with 4^preview_level times fewer vertices. Both consumers get their frames in order; frame_size is the size
+    // of the loaded images.
+    void RenderProgressive(const size_t image_count, const SequenceImageCache::LoadFunction &load_image, const std::vector<FeatureLineSpan> &feature_lines_of_images,
+      const size_t frame_count, const cv::Size &frame_size, const size_t preview_level,
+      const FramePipeline::ConsumeFunction &consume_preview, const FramePipeline::ConsumeFunction &consume);
+
+    // Loads pair pair_index of RenderPairs, called from the worker morphing it
+    typedef std::function<MorphPair(const size_t pair_index)> PairLoadFunction;
+
+    // Receives frame t_index of pair pair_index. Every frame of a pair that could not be morphed is empty: an image
+    // failed to load, the images differ in type, the lines are missing or differ in count, or a t is outside [0, 1].
+    typedef std::function<void(const size_t pair_index, const size_t t_index, const cv::Mat &frame)> PairConsumeFunction;
+
+    // Morphs every one of pair_count independent pairs at every value of ts. Pairs are loaded on demand and fitted
+    // to frame_size when needed (see FitImage), so all of them share the grid, the solver structure and the engine of each worker,
+    // which are only set up once for the whole batch. consume receives the frames pair after pair, as soon as a pair and
+    // all pairs before it are done, and at most a few pairs per worker are held in memory.
+    // The ts have no frame rate, so these frames are never motion blurred.
+    void RenderPairs(const size_t pair_count, const PairLoadFunction &load_pair, const std::vector<double> &ts, const cv::Size &frame_size,
+      const PairConsumeFunction &consume);
+
+    // Stops the running render: no frame is started afterwards and the render returns once the frames in flight are done,
+    // which may or may not reach consume. Every later render of this renderer returns at once.
+    // Safe to call from any thread, e.g. the one showing the frames.
+    void Cancel();
+
+    bool IsCanceled() const;
+
+    MorphOptions options_;
+
+    size_t thread_count_;
+
+    // Source images held in memory at once by the loading Render, 0 for no limit
+    size_t max_resident_images_;
+
+    // Threading of the last Render
+    SequenceThreading threading_;
+
+  private:
+
+    MorphSequenceRenderer(const MorphSequenceRenderer &) = delete;
+    MorphSequenceRenderer &operator =(const MorphSequenceRenderer &) = delete;
+
+    // Sets up threading_ for job_count jobs and an engine for each of its workers
+    void PrepareWorkers(const size_t job_count);
+
+    // Frames are motion blurred over shutter_t when options_ asks for sub-frames, sharp for a shutter_t of 0
+    void RenderFrames(SequenceImageCache &image_cache, const std::vector<MorphFrame> &frames, const double shutter_t,
+      const std::vector<FeatureLineSpan> &feature_lines_of_images,
+      const FramePipeline::ConsumeFunction &consume);
+
+    RenderBackendFactory render_backend_factory_;
+
+    // Keeps <atomic> out of the header, which code compiled with /clr cannot include
+    struct CancelState;
+
+    std::unique_ptr<CancelState> cancel_state_;
+
+    // Kept between renders, so the solvers keep the structure of their grid
+    std::vector<std::unique_ptr<MorphEngine> > morph_engines_;
+  };
+
+}
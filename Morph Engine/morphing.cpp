@@ -0,0 +1,105 @@
+#include "morphing.h"
+
+#include <iostream>
+
+#include <omp.h>
+
+#include "pixel_format.h"
+#include "pixel_kernels.h"
+#include "profiler.h"
+
+namespace ImageMorphing {
+
+  bool CheckMorphingParameters(const double t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines) {
+    if (t < 0 || t > 1) {
+      std::cerr << "Value of t must be in range[0, 1]\n";
+      return false;
+    }
+
+    if (source_feature_lines.size() != destination_feature_lines.size()) {
+      std::cerr << "Number of feature lines are not matching\n";
+      return false;
+    }
+
+    if (!source_feature_lines.size()) {
+      std::cerr << "No feature line\n";
+      return false;
+    }
+
+    return true;
+  }
+
+  bool CheckMorphingImages(const cv::Mat &source_image, const cv::Mat &destination_image) {
+    if (source_image.size() != destination_image.size() || source_image.type() != destination_image.type()) {
+      std::cerr << "Images must have the same size and type\n";
+      return false;
+    }
+
+    if (!IsSupportedImageType(source_image.type())) {
+      std::cerr << "Images must be 8-bit BGR or BGRA, 16-bit BGR or float BGR\n";
+      return false;
+    }
+
+    return true;
+  }
+
+  cv::Mat CrossDissolve(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const double t,
+    const BlendSpace blend_space) {
+    cv::Mat result_image(warped_source_image.size(), warped_source_image.type());
+    CrossDissolve(warped_source_image, warped_destination_image, t, result_image, blend_space);
+    return result_image;
+  }
+
+  void CrossDissolve(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const double t, cv::Mat &result_image,
+    const BlendSpace blend_space) {
+    if (blend_space == BlendSpace::LINEAR_LIGHT && result_image.depth() == CV_8U) {
+      CrossDissolve(warped_source_image, warped_destination_image, LinearLightBlendTable(t), result_image);
+      return;
+    }
+
+    MORPH_PROFILE_SCOPE(ProfileStage::BLEND);
+
+    // The blend does not depend on which channel is which, so rows are blended as flat runs of channels
+    const int element_count = result_image.cols * result_image.channels();
+
+#pragma omp parallel for
+    for (int r = 0; r < result_image.rows; ++r) {
+      switch (result_image.depth()) {
+      case CV_8U:
+        CrossDissolveRow(warped_source_image.ptr<uchar>(r), warped_destination_image.ptr<uchar>(r), t, result_image.ptr<uchar>(r), element_count);
+        break;
+      case CV_16U:
+        CrossDissolveRow(warped_source_image.ptr<ushort>(r), warped_destination_image.ptr<ushort>(r), t, result_image.ptr<ushort>(r), element_count);
+        break;
+      case CV_32F:
+        CrossDissolveRow(warped_source_image.ptr<float>(r), warped_destination_image.ptr<float>(r), t, result_image.ptr<float>(r), element_count);
+        break;
+      }
+    }
+  }
+
+  void CrossDissolve(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const LinearLightBlendTable &blend_table,
+    cv::Mat &result_image) {
+    if (result_image.depth() != CV_8U) {
+      CrossDissolve(warped_source_image, warped_destination_image, blend_table.t_, result_image);
+      return;
+    }
+
+    MORPH_PROFILE_SCOPE(ProfileStage::BLEND);
+
+    const bool has_alpha = result_image.channels() == 4;
+    const int element_count = result_image.cols * result_image.channels();
+
+#pragma omp parallel for
+    for (int r = 0; r < result_image.rows; ++r) {
+      if (has_alpha) {
+        CrossDissolvePremultipliedRowLinearLight(warped_source_image.ptr<uchar>(r), warped_destination_image.ptr<uchar>(r), blend_table, result_image.ptr<uchar>(r), result_image.cols);
+      } else {
+        CrossDissolveRowLinearLight(warped_source_image.ptr<uchar>(r), warped_destination_image.ptr<uchar>(r), blend_table, result_image.ptr<uchar>(r), element_count);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "feature_line.h"
+#include "linear_light.h"
+
+namespace ImageMorphing {
+
+  bool CheckMorphingParameters(const double t,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines);
+
+  // The images must match in size and type, and be of a type IsSupportedImageType accepts
+  bool CheckMorphingImages(const cv::Mat &source_image, const cv::Mat &destination_image);
+
+  cv::Mat CrossDissolve(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const double t,
+    const BlendSpace blend_space = BlendSpace::GAMMA);
+
+  // Writes into result_image, which must already have the size and type of the warped images.
+  // Blending in linear light builds a LinearLightBlendTable, the overload below reuses one.
+  void CrossDissolve(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const double t, cv::Mat &result_image,
+    const BlendSpace blend_space = BlendSpace::GAMMA);
+
+  // Cross dissolves in linear light at the t blend_table was updated for
+  void CrossDissolve(const cv::Mat &warped_source_image, const cv::Mat &warped_destination_image, const LinearLightBlendTable &blend_table,
+    cv::Mat &result_image);
+
+}
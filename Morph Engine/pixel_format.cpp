@@ -0,0 +1,322 @@
+#include "pixel_format.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include <omp.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    struct ImageTypeEntry {
+      int type_;
+      const char *name_;
+    };
+
+    const ImageTypeEntry IMAGE_TYPES[] = {
+      { CV_8UC3, "bgr8" },
+      { CV_8UC4, "bgra8" },
+      { CV_16UC3, "bgr16" },
+      { CV_32FC3, "bgr32f" }
+    };
+
+    // Value of full intensity at depth
+    double DepthMax(const int depth) {
+      switch (depth) {
+      case CV_8U:
+        return 255;
+      case CV_16U:
+        return 65535;
+      default:
+        return 1;
+      }
+    }
+
+    // Lower case extension of file_path without the dot
+    std::string FileExtension(const std::string &file_path) {
+      const size_t dot_position = file_path.find_last_of('.');
+      if (dot_position == std::string::npos) {
+        return "";
+      }
+
+      std::string extension = file_path.substr(dot_position + 1);
+      std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) {
+        return (char)std::tolower((unsigned char)c);
+      });
+
+      return extension;
+    }
+
+    // Whether the encoder chosen by the extension of file_path keeps samples of depth
+    bool IsDepthEncodable(const std::string &file_path, const int depth) {
+      const std::string extension = FileExtension(file_path);
+
+      switch (depth) {
+      case CV_8U:
+        return true;
+      case CV_16U:
+        return extension == "png" || extension == "tif" || extension == "tiff";
+      case CV_32F:
+        return extension == "exr" || extension == "tif" || extension == "tiff" || extension == "hdr";
+      default:
+        return false;
+      }
+    }
+
+    // Integers of byte_count bytes, as image headers store them. Four byte ones are signed.
+    int ReadBigEndian(const unsigned char *bytes, const int byte_count) {
+      unsigned int value = 0;
+      for (int i = 0; i < byte_count; ++i) {
+        value = value << 8 | bytes[i];
+      }
+      return (int)value;
+    }
+
+    int ReadLittleEndian(const unsigned char *bytes, const int byte_count) {
+      unsigned int value = 0;
+      for (int i = byte_count - 1; i >= 0; --i) {
+        value = value << 8 | bytes[i];
+      }
+      return (int)value;
+    }
+
+    // Size of the first frame of a JPEG stream, from its start of frame segment
+    bool ReadJPEGSize(std::istream &stream, cv::Size &size) {
+      for (;;) {
+        int byte = stream.get();
+        if (byte != 0xFF) {
+          return false;
+        }
+
+        // Markers may be padded with any number of 0xFF
+        while (byte == 0xFF) {
+          byte = stream.get();
+        }
+
+        const int marker = byte;
+
+        // Markers without a segment
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+          continue;
+        }
+
+        // The image data starts, or the stream ends, without a frame header
+        if (marker == 0xDA || marker == 0xD9 || marker == EOF) {
+          return false;
+        }
+
+        unsigned char segment[7];
+        if (!stream.read((char *)segment, 2)) {
+          return false;
+        }
+
+        const int segment_length = ReadBigEndian(segment, 2);
+        if (segment_length < 2) {
+          return false;
+        }
+
+        // Start of frame markers, other than the Huffman table (C4), the extension (C8) and the arithmetic coding table (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+          if (segment_length < 7 || !stream.read((char *)segment + 2, 5)) {
+            return false;
+          }
+
+          size = cv::Size(ReadBigEndian(segment + 5, 2), ReadBigEndian(segment + 3, 2));
+          return true;
+        }
+
+        if (!stream.seekg(segment_length - 2, std::ios::cur)) {
+          return false;
+        }
+      }
+    }
+
+
+  }
+
+  bool IsSupportedImageType(const int type) {
+    for (const ImageTypeEntry &image_type : IMAGE_TYPES) {
+      if (image_type.type_ == type) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  std::string ImageTypeName(const int type) {
+    for (const ImageTypeEntry &image_type : IMAGE_TYPES) {
+      if (image_type.type_ == type) {
+        return image_type.name_;
+      }
+    }
+
+    return "unsupported";
+  }
+
+  bool ParseImageType(const std::string &name, int &type) {
+    for (const ImageTypeEntry &image_type : IMAGE_TYPES) {
+      if (name == image_type.name_) {
+        type = image_type.type_;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  cv::Mat PremultiplyAlpha(const cv::Mat &image) {
+    if (image.type() != CV_8UC4) {
+      return image;
+    }
+
+    cv::Mat premultiplied_image(image.size(), image.type());
+
+#pragma omp parallel for
+    for (int r = 0; r < image.rows; ++r) {
+      const cv::Vec4b *pixels = image.ptr<cv::Vec4b>(r);
+      cv::Vec4b *premultiplied_pixels = premultiplied_image.ptr<cv::Vec4b>(r);
+
+      for (int c = 0; c < image.cols; ++c) {
+        const int alpha = pixels[c][3];
+
+        for (int k = 0; k < 3; ++k) {
+          premultiplied_pixels[c][k] = (uchar)((pixels[c][k] * alpha + 127) / 255);
+        }
+        premultiplied_pixels[c][3] = (uchar)alpha;
+      }
+    }
+
+    return premultiplied_image;
+  }
+
+  cv::Mat UnpremultiplyAlpha(const cv::Mat &image) {
+    if (image.type() != CV_8UC4) {
+      return image;
+    }
+
+    cv::Mat straight_image(image.size(), image.type());
+
+#pragma omp parallel for
+    for (int r = 0; r < image.rows; ++r) {
+      const cv::Vec4b *pixels = image.ptr<cv::Vec4b>(r);
+      cv::Vec4b *straight_pixels = straight_image.ptr<cv::Vec4b>(r);
+
+      for (int c = 0; c < image.cols; ++c) {
+        const int alpha = pixels[c][3];
+
+        // Fully transparent pixels have no color left to recover
+        for (int k = 0; k < 3; ++k) {
+          straight_pixels[c][k] = alpha ? cv::saturate_cast<uchar>((pixels[c][k] * 255 + alpha / 2) / alpha) : 0;
+        }
+        straight_pixels[c][3] = (uchar)alpha;
+      }
+    }
+
+    return straight_image;
+  }
+
+  cv::Mat ConvertImageType(const cv::Mat &image, const int type) {
+    if (image.type() == type) {
+      return image.clone();
+    }
+
+    cv::Mat converted_image = DropAlpha(image);
+
+    if (converted_image.depth() != CV_MAT_DEPTH(type)) {
+      converted_image.convertTo(converted_image, CV_MAT_DEPTH(type), DepthMax(CV_MAT_DEPTH(type)) / DepthMax(image.depth()));
+    }
+
+    if (CV_MAT_CN(type) == 4) {
+      cv::cvtColor(converted_image, converted_image, cv::COLOR_BGR2BGRA);
+    }
+
+    return converted_image;
+  }
+
+  cv::Mat ReadImage(const std::string &file_path, const int type) {
+    if (type != CV_8UC4) {
+      cv::Mat image = cv::imread(file_path, cv::IMREAD_ANYDEPTH | cv::IMREAD_COLOR);
+      return image.empty() || image.type() == type ? image : ConvertImageType(image, type);
+    }
+
+    cv::Mat image = cv::imread(file_path, cv::IMREAD_UNCHANGED);
+    if (image.empty()) {
+      return image;
+    }
+
+    if (image.depth() != CV_8U) {
+      image.convertTo(image, CV_8U, DepthMax(CV_8U) / DepthMax(image.depth()));
+    }
+
+    switch (image.channels()) {
+    case 1:
+      cv::cvtColor(image, image, cv::COLOR_GRAY2BGRA);
+      return image;
+    case 3:
+      return ConvertImageType(image, type);
+    default:
+      return PremultiplyAlpha(image);
+    }
+  }
+
+  bool ReadImageSize(const std::string &file_path, cv::Size &size) {
+    std::ifstream stream(file_path, std::ios::binary);
+
+    unsigned char header[26];
+    if (!stream.read((char *)header, sizeof(header))) {
+      return false;
+    }
+
+    const unsigned char PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    // The IHDR chunk comes first
+    if (!std::memcmp(header, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) && !std::memcmp(header + 12, "IHDR", 4)) {
+      size = cv::Size(ReadBigEndian(header + 16, 4), ReadBigEndian(header + 20, 4));
+      return size.width > 0 && size.height > 0;
+    }
+
+    // Bottom up bitmaps have a positive height, top down ones a negative height
+    if (header[0] == 'B' && header[1] == 'M' && ReadLittleEndian(header + 14, 4) >= 40) {
+      size = cv::Size(ReadLittleEndian(header + 18, 4), std::abs(ReadLittleEndian(header + 22, 4)));
+      return size.width > 0 && size.height > 0;
+    }
+
+    if (header[0] == 0xFF && header[1] == 0xD8) {
+      stream.seekg(2);
+      return ReadJPEGSize(stream, size) && size.width > 0 && size.height > 0;
+    }
+
+    return false;
+  }
+
+  bool WriteImage(const std::string &file_path, const cv::Mat &image, const std::vector<int> &encode_parameters) {
+    if (!IsDepthEncodable(file_path, image.depth())) {
+      return cv::imwrite(file_path, UnpremultiplyAlpha(ConvertImageType(image, CV_MAKETYPE(CV_8U, image.channels()))), encode_parameters);
+    }
+
+    return cv::imwrite(file_path, UnpremultiplyAlpha(image), encode_parameters);
+  }
+
+  cv::Mat DropAlpha(const cv::Mat &image) {
+    if (image.channels() != 4) {
+      return image;
+    }
+
+    // Premultiplied colors already are the composite over black
+    cv::Mat bgr_image;
+    cv::cvtColor(image, bgr_image, cv::COLOR_BGRA2BGR);
+    return bgr_image;
+  }
+
+  cv::Mat To8BitBGR(const cv::Mat &image) {
+    return image.type() == CV_8UC3 ? image : ConvertImageType(image, CV_8UC3);
+  }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  // Pixel types every stage of the pipeline handles: 8-bit BGR, 8-bit BGRA with premultiplied alpha, 16-bit BGR
+  // and float BGR. Pixels of a warped BGRA image no triangle covers are fully transparent.
+  // Float images are in [0, 1] when converted from integers, brighter HDR values are kept as they are.
+  bool IsSupportedImageType(const int type);
+
+  // Short name of a supported type: "bgr8", "bgra8", "bgr16" or "bgr32f"
+  std::string ImageTypeName(const int type);
+
+  bool ParseImageType(const std::string &name, int &type);
+
+  // Straight alpha, as image files store it, to premultiplied alpha and back. BGR images are returned as they are.
+  cv::Mat PremultiplyAlpha(const cv::Mat &image);
+  cv::Mat UnpremultiplyAlpha(const cv::Mat &image);
+
+  // Copy of image, of any supported type, converted to type. BGR gets opaque alpha, BGRA is shown over black,
+  // and the full range of one depth maps to the full range of the other.
+  cv::Mat ConvertImageType(const cv::Mat &image, const int type);
+
+  // Decodes file_path into an image of a supported type, keeping the depth of 16-bit and float files (PNG, TIFF, EXR)
+  // until it is converted. Files without alpha read as BGRA are opaque. Returns an empty image if the file cannot be read.
+  cv::Mat ReadImage(const std::string &file_path, const int type = CV_8UC3);
+
+  // Size of the image of file_path, read from the header of PNG, BMP and JPEG files without decoding the pixels.
+  // Returns false for other formats and unreadable files, which have to be decoded to tell.
+  bool ReadImageSize(const std::string &file_path, cv::Size &size);
+
+  // Encodes image with the straight alpha the file formats expect. 16-bit images are written as they are to PNG and TIFF,
+  // float images to EXR, TIFF and HDR, and converted to 8 bits for any other format.
+  bool WriteImage(const std::string &file_path, const cv::Mat &image, const std::vector<int> &encode_parameters = std::vector<int>());
+
+  // BGR copy of a BGRA frame composited over black, for outputs without alpha. BGR frames are returned as they are.
+  cv::Mat DropAlpha(const cv::Mat &image);
+
+  // 8-bit BGR version of a frame, for outputs and displays that take nothing else. Float values above 1 saturate.
+  // 8-bit BGR frames are returned as they are.
+  cv::Mat To8BitBGR(const cv::Mat &image);
+
+}
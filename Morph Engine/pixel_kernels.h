@@ -0,0 +1,315 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+
+#include <opencv2/core.hpp>
+
+#include "linear_light.h"
+#include "texture_filter.h"
+
+// SSE2 is part of every x64 target, and of x86 builds with /arch:SSE2, the default since Visual Studio 2012
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MORPH_SSE2
+#include <emmintrin.h>
+#endif
+
+// Per-pixel kernels of the warps and the blend, templated on the channel type T and the channel count of the images.
+// 4-channel images carry premultiplied alpha, so alpha is sampled and blended like any other channel.
+
+namespace ImageMorphing {
+
+  // Bilinear sample at pixel_position, which must be inside the image. The last row and column have no neighbour to blend with.
+  template <typename T, int channel_count>
+  inline cv::Vec<double, channel_count> BilinearSample(const cv::Mat &image, const cv::Point2d &pixel_position) {
+    typedef cv::Vec<T, channel_count> Pixel;
+    typedef cv::Vec<double, channel_count> Color;
+
+    const int x = (int)pixel_position.x;
+    const int y = (int)pixel_position.y;
+
+    Color upper_left = image.at<Pixel>(y, x);
+    if (x >= image.cols - 1 || y >= image.rows - 1) {
+      return upper_left;
+    }
+    Color lower_left = image.at<Pixel>(y + 1, x);
+    Color upper_right = image.at<Pixel>(y, x + 1);
+    Color lower_right = image.at<Pixel>(y + 1, x + 1);
+
+    const double t1 = pixel_position.x - x;
+    const double t2 = pixel_position.y - y;
+
+    Color upper_pixel_value = upper_left * (1 - t1) + upper_right * t1;
+    Color lower_pixel_value = lower_left * (1 - t1) + lower_right * t1;
+
+    return upper_pixel_value * (1 - t2) + lower_pixel_value * t2;
+  }
+
+  template <typename T, int channel_count>
+  inline void BilinearSampleTo(const cv::Mat &image, const cv::Point2d &pixel_position, T *pixel) {
+    const cv::Vec<double, channel_count> color = BilinearSample<T, channel_count>(image, pixel_position);
+
+    for (int k = 0; k < channel_count; ++k) {
+      pixel[k] = cv::saturate_cast<T>(color[k]);
+    }
+  }
+
+#ifdef MORPH_SSE2
+
+  // 8-bit BGR and BGRA in fixed point, with positions rounded to 1/128 pixel. Samples differ from the exact ones
+  // by at most two levels, and only across the sharpest edges.
+  template <int channel_count>
+  inline void BilinearSampleTo8BitSSE2(const cv::Mat &image, const cv::Point2d &pixel_position, uchar *pixel) {
+    const int x = (int)pixel_position.x;
+    const int y = (int)pixel_position.y;
+
+    const uchar *upper = image.ptr<uchar>(y) + x * channel_count;
+
+    if (x >= image.cols - 1 || y >= image.rows - 1) {
+      std::memcpy(pixel, upper, channel_count);
+      return;
+    }
+
+    const uchar *lower = image.ptr<uchar>(y + 1) + x * channel_count;
+
+    const int fraction_x = (int)((pixel_position.x - x) * 128 + 0.5);
+    const int fraction_y = (int)((pixel_position.y - y) * 128 + 0.5);
+
+    // Each pair of 16-bit weights sums to 2^14 over the four neighbours
+    const int upper_left_weight = (128 - fraction_x) * (128 - fraction_y);
+    const int upper_right_weight = fraction_x * (128 - fraction_y);
+    const int lower_left_weight = (128 - fraction_x) * fraction_y;
+    const int lower_right_weight = fraction_x * fraction_y;
+
+    // Two neighbouring pixels, copied rather than loaded so a 3-channel row is never read past its end
+    long long upper_pixels = 0;
+    long long lower_pixels = 0;
+    std::memcpy(&upper_pixels, upper, 2 * channel_count);
+    std::memcpy(&lower_pixels, lower, 2 * channel_count);
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i upper_channels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&upper_pixels)), zero);
+    __m128i lower_channels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&lower_pixels)), zero);
+
+    // Interleaves every channel of the left pixel with the same channel of the right one, so one madd weighs both
+    upper_channels = _mm_unpacklo_epi16(upper_channels, _mm_srli_si128(upper_channels, 2 * channel_count));
+    lower_channels = _mm_unpacklo_epi16(lower_channels, _mm_srli_si128(lower_channels, 2 * channel_count));
+
+    __m128i color = _mm_add_epi32(
+      _mm_madd_epi16(upper_channels, _mm_set1_epi32((upper_right_weight << 16) | upper_left_weight)),
+      _mm_madd_epi16(lower_channels, _mm_set1_epi32((lower_right_weight << 16) | lower_left_weight)));
+    color = _mm_srli_epi32(_mm_add_epi32(color, _mm_set1_epi32(1 << 13)), 14);
+    color = _mm_packus_epi16(_mm_packs_epi32(color, color), zero);
+
+    const int packed_color = _mm_cvtsi128_si32(color);
+    std::memcpy(pixel, &packed_color, channel_count);
+  }
+
+  template <>
+  inline void BilinearSampleTo<uchar, 3>(const cv::Mat &image, const cv::Point2d &pixel_position, uchar *pixel) {
+    BilinearSampleTo8BitSSE2<3>(image, pixel_position, pixel);
+  }
+
+  template <>
+  inline void BilinearSampleTo<uchar, 4>(const cv::Mat &image, const cv::Point2d &pixel_position, uchar *pixel) {
+    BilinearSampleTo8BitSSE2<4>(image, pixel_position, pixel);
+  }
+
+  inline __m128 LoadPixelAsFloats(const ushort *pixel) {
+    return _mm_setr_ps(pixel[0], pixel[1], pixel[2], 0);
+  }
+
+  inline __m128 LoadPixelAsFloats(const float *pixel) {
+    return _mm_setr_ps(pixel[0], pixel[1], pixel[2], 0);
+  }
+
+  inline void StoreFloatsAsPixel(const __m128 color, ushort *pixel) {
+    // Rounds to nearest like saturate_cast, a bilinear sample never leaves the range of its neighbours
+    const __m128i channels = _mm_cvtps_epi32(color);
+    pixel[0] = (ushort)_mm_cvtsi128_si32(channels);
+    pixel[1] = (ushort)_mm_cvtsi128_si32(_mm_srli_si128(channels, 4));
+    pixel[2] = (ushort)_mm_cvtsi128_si32(_mm_srli_si128(channels, 8));
+  }
+
+  inline void StoreFloatsAsPixel(const __m128 color, float *pixel) {
+    float channels[4];
+    _mm_storeu_ps(channels, color);
+    std::memcpy(pixel, channels, 3 * sizeof(float));
+  }
+
+  // 16-bit and float BGR in single precision, with all channels of a pixel in one vector.
+  // Float channels are not clamped, so values above 1 survive the warp.
+  template <typename T>
+  inline void BilinearSampleTo3ChannelSSE2(const cv::Mat &image, const cv::Point2d &pixel_position, T *pixel) {
+    const int x = (int)pixel_position.x;
+    const int y = (int)pixel_position.y;
+
+    const T *upper = image.ptr<T>(y) + x * 3;
+
+    if (x >= image.cols - 1 || y >= image.rows - 1) {
+      std::memcpy(pixel, upper, 3 * sizeof(T));
+      return;
+    }
+
+    const T *lower = image.ptr<T>(y + 1) + x * 3;
+
+    const __m128 t1 = _mm_set1_ps((float)(pixel_position.x - x));
+    const __m128 t2 = _mm_set1_ps((float)(pixel_position.y - y));
+    const __m128 one = _mm_set1_ps(1);
+
+    const __m128 upper_color = _mm_add_ps(_mm_mul_ps(LoadPixelAsFloats(upper), _mm_sub_ps(one, t1)), _mm_mul_ps(LoadPixelAsFloats(upper + 3), t1));
+    const __m128 lower_color = _mm_add_ps(_mm_mul_ps(LoadPixelAsFloats(lower), _mm_sub_ps(one, t1)), _mm_mul_ps(LoadPixelAsFloats(lower + 3), t1));
+
+    StoreFloatsAsPixel(_mm_add_ps(_mm_mul_ps(upper_color, _mm_sub_ps(one, t2)), _mm_mul_ps(lower_color, t2)), pixel);
+  }
+
+  template <>
+  inline void BilinearSampleTo<ushort, 3>(const cv::Mat &image, const cv::Point2d &pixel_position, ushort *pixel) {
+    BilinearSampleTo3ChannelSSE2(image, pixel_position, pixel);
+  }
+
+  template <>
+  inline void BilinearSampleTo<float, 3>(const cv::Mat &image, const cv::Point2d &pixel_position, float *pixel) {
+    BilinearSampleTo3ChannelSSE2(image, pixel_position, pixel);
+  }
+
+#endif
+
+  // Writes the sample of image at pixel_position to pixel, with the filtering the CPU backends support
+  template <typename T, int channel_count>
+  inline void SampleTo(const cv::Mat &image, const cv::Point2d &pixel_position, const TextureFilter texture_filter, T *pixel) {
+    if (texture_filter == TextureFilter::NEAREST) {
+      const T *nearest_pixel = image.ptr<T>((int)(pixel_position.y + 0.5)) + (int)(pixel_position.x + 0.5) * channel_count;
+      std::memcpy(pixel, nearest_pixel, channel_count * sizeof(T));
+    } else {
+      BilinearSampleTo<T, channel_count>(image, pixel_position, pixel);
+    }
+  }
+
+  // result = source * (1 - t) + destination * t over element_count channels. With premultiplied alpha this is also
+  // the correct blend of two BGRA pixels.
+  template <typename T>
+  inline void CrossDissolveRow(const T *source, const T *destination, const double t, T *result, const int element_count) {
+    for (int i = 0; i < element_count; ++i) {
+      result[i] = cv::saturate_cast<T>(source[i] * (1 - t) + destination[i] * t);
+    }
+  }
+
+  // 8 bits in fixed point with weights of 1/2^14, 16 channels at a time with SSE2
+  template <>
+  inline void CrossDissolveRow<uchar>(const uchar *source, const uchar *destination, const double t, uchar *result, const int element_count) {
+    const int destination_weight = (int)(t * (1 << 14) + 0.5);
+    const int source_weight = (1 << 14) - destination_weight;
+
+    int i = 0;
+
+#ifdef MORPH_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_set1_epi32((destination_weight << 16) | source_weight);
+    const __m128i rounding = _mm_set1_epi32(1 << 13);
+
+    for (; i + 16 <= element_count; i += 16) {
+      const __m128i source_channels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+      const __m128i destination_channels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(destination + i));
+
+      const __m128i source_low = _mm_unpacklo_epi8(source_channels, zero);
+      const __m128i source_high = _mm_unpackhi_epi8(source_channels, zero);
+      const __m128i destination_low = _mm_unpacklo_epi8(destination_channels, zero);
+      const __m128i destination_high = _mm_unpackhi_epi8(destination_channels, zero);
+
+      // Every source channel next to its destination channel, weighed and summed by one madd
+      __m128i blended[4] = {
+        _mm_madd_epi16(_mm_unpacklo_epi16(source_low, destination_low), weights),
+        _mm_madd_epi16(_mm_unpackhi_epi16(source_low, destination_low), weights),
+        _mm_madd_epi16(_mm_unpacklo_epi16(source_high, destination_high), weights),
+        _mm_madd_epi16(_mm_unpackhi_epi16(source_high, destination_high), weights)
+      };
+
+      for (int k = 0; k < 4; ++k) {
+        blended[k] = _mm_srli_epi32(_mm_add_epi32(blended[k], rounding), 14);
+      }
+
+      const __m128i result_channels = _mm_packus_epi16(_mm_packs_epi32(blended[0], blended[1]), _mm_packs_epi32(blended[2], blended[3]));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i), result_channels);
+    }
+#endif
+
+    for (; i < element_count; ++i) {
+      result[i] = (uchar)((source[i] * source_weight + destination[i] * destination_weight + (1 << 13)) >> 14);
+    }
+  }
+
+  // 16 bits in single precision, 8 channels at a time with SSE2
+  template <>
+  inline void CrossDissolveRow<ushort>(const ushort *source, const ushort *destination, const double t, ushort *result, const int element_count) {
+    const float source_weight = (float)(1 - t);
+    const float destination_weight = (float)t;
+
+    int i = 0;
+
+#ifdef MORPH_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 source_weights = _mm_set1_ps(source_weight);
+    const __m128 destination_weights = _mm_set1_ps(destination_weight);
+
+    // SSE2 only packs 32-bit integers to signed 16-bit ones, so results are moved into that range and back
+    const __m128i signed_offset = _mm_set1_epi32(1 << 15);
+    const __m128i sign_bits = _mm_set1_epi16((short)0x8000);
+
+    for (; i + 8 <= element_count; i += 8) {
+      const __m128i source_channels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+      const __m128i destination_channels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(destination + i));
+
+      const __m128 blended_low = _mm_add_ps(
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(source_channels, zero)), source_weights),
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(destination_channels, zero)), destination_weights));
+      const __m128 blended_high = _mm_add_ps(
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(source_channels, zero)), source_weights),
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(destination_channels, zero)), destination_weights));
+
+      const __m128i result_channels = _mm_xor_si128(_mm_packs_epi32(
+        _mm_sub_epi32(_mm_cvtps_epi32(blended_low), signed_offset),
+        _mm_sub_epi32(_mm_cvtps_epi32(blended_high), signed_offset)), sign_bits);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i), result_channels);
+    }
+#endif
+
+    for (; i < element_count; ++i) {
+      result[i] = cv::saturate_cast<ushort>(source[i] * source_weight + destination[i] * destination_weight);
+    }
+  }
+
+  // Float in single precision, 4 channels at a time with SSE2. Values outside of [0, 1] are kept.
+  template <>
+  inline void CrossDissolveRow<float>(const float *source, const float *destination, const double t, float *result, const int element_count) {
+    const float source_weight = (float)(1 - t);
+    const float destination_weight = (float)t;
+
+    int i = 0;
+
+#ifdef MORPH_SSE2
+    const __m128 source_weights = _mm_set1_ps(source_weight);
+    const __m128 destination_weights = _mm_set1_ps(destination_weight);
+
+    for (; i + 4 <= element_count; i += 4) {
+      const __m128 blended = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + i), source_weights), _mm_mul_ps(_mm_loadu_ps(destination + i), destination_weights));
+      _mm_storeu_ps(result + i, blended);
+    }
+#endif
+
+    for (; i < element_count; ++i) {
+      result[i] = source[i] * source_weight + destination[i] * destination_weight;
+    }
+  }
+
+  // CrossDissolveRow of 8-bit channels without alpha in linear light, one lookup of blend_table per channel. SSE2 has no gather,
+  // so the lookups stay scalar, the decode, blend and encode they stand for are done once per pair of values.
+  inline void CrossDissolveRowLinearLight(const uchar *source, const uchar *destination, const LinearLightBlendTable &blend_table, uchar *result, const int element_count) {
+    const uchar *colors = blend_table.colors_.data();
+
+    for (int i = 0; i < element_count; ++i) {
+      result[i] = colors[source[i] << 8 | destination[i]];
+    }
+  }
+
+}
@@ -0,0 +1,268 @@
+#include "profiler.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#ifdef _MSC_VER
+#define MORPH_THREAD_LOCAL __declspec(thread)
+#else
+#define MORPH_THREAD_LOCAL thread_local
+#endif
+
+namespace ImageMorphing {
+
+  namespace {
+
+    const long long NO_FRAME_INDEX = -1;
+
+    struct ProfileEvent {
+      ProfileStage stage_;
+      long long frame_index_;
+      int thread_index_;
+      long long start_time_;
+      long long duration_;
+    };
+
+    typedef std::array<long long, (size_t)ProfileCounter::COUNT> ProfileCounts;
+
+    struct Profile {
+
+      Profile() : is_enabled_(false), epoch_(0), thread_count_(0) {
+      }
+
+      std::atomic<bool> is_enabled_;
+
+      // Microseconds of the steady clock at the last reset
+      std::atomic<long long> epoch_;
+
+      std::atomic<int> thread_count_;
+
+      std::mutex mutex_;
+
+      std::vector<ProfileEvent> events_;
+      std::map<long long, ProfileCounts> counts_of_frames_;
+    };
+
+    Profile profile;
+
+    MORPH_THREAD_LOCAL long long current_frame_index = NO_FRAME_INDEX;
+
+    // 0 until the thread records its first event
+    MORPH_THREAD_LOCAL int current_thread_index = 0;
+
+    long long SteadyClockMicroseconds() {
+      return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    long long ProfileTime() {
+      return SteadyClockMicroseconds() - profile.epoch_.load(std::memory_order_relaxed);
+    }
+
+    int CurrentThreadIndex() {
+      if (!current_thread_index) {
+        current_thread_index = ++profile.thread_count_;
+      }
+      return current_thread_index;
+    }
+
+    ProfileCounts &CountsOfFrame(const long long frame_index) {
+      auto counts = profile.counts_of_frames_.find(frame_index);
+
+      if (counts == profile.counts_of_frames_.end()) {
+        counts = profile.counts_of_frames_.insert(std::make_pair(frame_index, ProfileCounts())).first;
+        counts->second.fill(0);
+      }
+
+      return counts->second;
+    }
+
+  }
+
+  const char *ProfileStageName(const ProfileStage stage) {
+    switch (stage) {
+    case ProfileStage::LINE_INTERPOLATION:
+      return "line_interpolation";
+    case ProfileStage::VERTEX_TARGETS:
+      return "vertex_targets";
+    case ProfileStage::MODEL_BUILD:
+      return "model_build";
+    case ProfileStage::SOLVE:
+      return "solve";
+    case ProfileStage::TEXTURE_UPLOAD:
+      return "texture_upload";
+    case ProfileStage::DRAW:
+      return "draw";
+    case ProfileStage::READBACK:
+      return "readback";
+    case ProfileStage::BLEND:
+      return "blend";
+    case ProfileStage::ENCODE:
+      return "encode";
+    default:
+      return "unknown";
+    }
+  }
+
+  const char *ProfileCounterName(const ProfileCounter counter) {
+    switch (counter) {
+    case ProfileCounter::MORPHED_FRAMES:
+      return "morphed_frames";
+    case ProfileCounter::SOLVES:
+      return "solves";
+    case ProfileCounter::INTERPOLATED_FEATURE_LINES:
+      return "interpolated_feature_lines";
+    case ProfileCounter::UPLOADED_BYTES:
+      return "uploaded_bytes";
+    case ProfileCounter::DRAWN_TRIANGLES:
+      return "drawn_triangles";
+    case ProfileCounter::READ_BACK_BYTES:
+      return "read_back_bytes";
+    case ProfileCounter::ENCODED_FRAMES:
+      return "encoded_frames";
+    default:
+      return "unknown";
+    }
+  }
+
+  void EnableProfiling(const bool is_enabled) {
+    profile.is_enabled_.store(is_enabled, std::memory_order_relaxed);
+  }
+
+  bool IsProfilingEnabled() {
+    return profile.is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  void ResetProfile() {
+    std::lock_guard<std::mutex> lock(profile.mutex_);
+
+    profile.events_.clear();
+    profile.counts_of_frames_.clear();
+    profile.epoch_.store(SteadyClockMicroseconds(), std::memory_order_relaxed);
+  }
+
+  void CountProfileEvent(const ProfileCounter counter, const long long amount) {
+    if (!IsProfilingEnabled()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(profile.mutex_);
+
+    CountsOfFrame(current_frame_index)[(size_t)counter] += amount;
+  }
+
+  bool SaveProfileJSON(const std::string &file_path) {
+    std::ofstream profile_file(file_path);
+
+    if (!profile_file) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profile.mutex_);
+
+    typedef std::array<long long, (size_t)ProfileStage::COUNT> ProfileDurations;
+
+    std::map<long long, ProfileDurations> durations_of_frames;
+
+    for (const auto &event : profile.events_) {
+      auto durations = durations_of_frames.find(event.frame_index_);
+
+      if (durations == durations_of_frames.end()) {
+        durations = durations_of_frames.insert(std::make_pair(event.frame_index_, ProfileDurations())).first;
+        durations->second.fill(0);
+      }
+
+      durations->second[(size_t)event.stage_] += event.duration_;
+    }
+
+    for (const auto &counts : profile.counts_of_frames_) {
+      if (!durations_of_frames.count(counts.first)) {
+        durations_of_frames[counts.first].fill(0);
+      }
+    }
+
+    profile_file << "{\n  \"frames\": [";
+
+    bool is_first_frame = true;
+
+    for (const auto &durations : durations_of_frames) {
+      profile_file << (is_first_frame ? "\n" : ",\n") << "    {\"frame\": " << durations.first << ", \"stages\": {";
+      is_first_frame = false;
+
+      for (size_t stage = 0; stage < (size_t)ProfileStage::COUNT; ++stage) {
+        profile_file << (stage ? ", " : "") << "\"" << ProfileStageName((ProfileStage)stage) << "\": " << durations.second[stage] / 1000.0;
+      }
+
+      profile_file << "}, \"counters\": {";
+
+      const auto counts = profile.counts_of_frames_.find(durations.first);
+
+      for (size_t counter = 0; counter < (size_t)ProfileCounter::COUNT; ++counter) {
+        profile_file << (counter ? ", " : "") << "\"" << ProfileCounterName((ProfileCounter)counter) << "\": "
+          << (counts != profile.counts_of_frames_.end() ? counts->second[counter] : 0);
+      }
+
+      profile_file << "}}";
+    }
+
+    profile_file << "\n  ],\n  \"time_unit\": \"ms\"\n}\n";
+
+    return (bool)profile_file;
+  }
+
+  bool SaveProfileChromeTrace(const std::string &file_path) {
+    std::ofstream trace_file(file_path);
+
+    if (!trace_file) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profile.mutex_);
+
+    trace_file << "{\"traceEvents\": [";
+
+    for (size_t i = 0; i < profile.events_.size(); ++i) {
+      const ProfileEvent &event = profile.events_[i];
+
+      trace_file << (i ? ",\n" : "\n") << "{\"name\": \"" << ProfileStageName(event.stage_) << "\", \"cat\": \"morph\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread_index_
+        << ", \"ts\": " << event.start_time_ << ", \"dur\": " << event.duration_ << ", \"args\": {\"frame\": " << event.frame_index_ << "}}";
+    }
+
+    trace_file << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+    return (bool)trace_file;
+  }
+
+  ProfileScope::ProfileScope(const ProfileStage stage) : stage_(stage), start_time_(IsProfilingEnabled() ? ProfileTime() : -1) {
+  }
+
+  ProfileScope::~ProfileScope() {
+    if (start_time_ < 0) {
+      return;
+    }
+
+    ProfileEvent event;
+    event.stage_ = stage_;
+    event.frame_index_ = current_frame_index;
+    event.thread_index_ = CurrentThreadIndex();
+    event.start_time_ = start_time_;
+    event.duration_ = ProfileTime() - start_time_;
+
+    std::lock_guard<std::mutex> lock(profile.mutex_);
+
+    profile.events_.push_back(event);
+  }
+
+  ProfileFrameScope::ProfileFrameScope(const long long frame_index) : previous_frame_index_(current_frame_index) {
+    current_frame_index = frame_index;
+  }
+
+  ProfileFrameScope::~ProfileFrameScope() {
+    current_frame_index = previous_frame_index_;
+  }
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+
+// Define MORPH_NO_PROFILING to compile every profiling macro out of the engine
+#ifndef MORPH_NO_PROFILING
+#define MORPH_PROFILE_CONCATENATE_(a, b) a##b
+#define MORPH_PROFILE_CONCATENATE(a, b) MORPH_PROFILE_CONCATENATE_(a, b)
+#define MORPH_PROFILE_SCOPE(stage) ImageMorphing::ProfileScope MORPH_PROFILE_CONCATENATE(profile_scope_, __LINE__)(stage)
+#define MORPH_PROFILE_FRAME(frame_index) ImageMorphing::ProfileFrameScope MORPH_PROFILE_CONCATENATE(profile_frame_scope_, __LINE__)(frame_index)
+#define MORPH_PROFILE_COUNT(counter, amount) ImageMorphing::CountProfileEvent(counter, amount)
+#else
+#define MORPH_PROFILE_SCOPE(stage)
+#define MORPH_PROFILE_FRAME(frame_index)
+#define MORPH_PROFILE_COUNT(counter, amount)
+#endif
+
+namespace ImageMorphing {
+
+  enum class ProfileStage {
+    LINE_INTERPOLATION,
+    // Field warping of the grid vertices
+    VERTEX_TARGETS,
+    // Constraints of a new grid topology and the objective of every solve
+    MODEL_BUILD,
+    SOLVE,
+    TEXTURE_UPLOAD,
+    DRAW,
+    // GL draws run asynchronously, so the readback also waits for the GPU to finish them
+    READBACK,
+    BLEND,
+    ENCODE,
+    COUNT
+  };
+
+  enum class ProfileCounter {
+    MORPHED_FRAMES,
+    SOLVES,
+    INTERPOLATED_FEATURE_LINES,
+    UPLOADED_BYTES,
+    DRAWN_TRIANGLES,
+    READ_BACK_BYTES,
+    ENCODED_FRAMES,
+    COUNT
+  };
+
+  const char *ProfileStageName(const ProfileStage stage);
+
+  const char *ProfileCounterName(const ProfileCounter counter);
+
+  // Profiling is off until enabled, a disabled scope costs one relaxed atomic load.
+  // Events are kept in memory until ResetProfile, so only enable it for the runs being measured.
+  void EnableProfiling(const bool is_enabled);
+
+  bool IsProfilingEnabled();
+
+  void ResetProfile();
+
+  void CountProfileEvent(const ProfileCounter counter, const long long amount);
+
+  // Total time and counters of every frame, as {"frames": [{"frame": 0, "stages": {"solve": ms, ...}, "counters": {...}}, ...]}.
+  // Work done outside of any frame scope is reported under frame -1.
+  bool SaveProfileJSON(const std::string &file_path);
+
+  // Every timed scope as a complete event of the Chrome trace event format, for chrome://tracing or Perfetto
+  bool SaveProfileChromeTrace(const std::string &file_path);
+
+  // Times its stage from construction to destruction
+  class ProfileScope {
+
+  public:
+
+    explicit ProfileScope(const ProfileStage stage);
+
+    ~ProfileScope();
+
+  private:
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator =(const ProfileScope &) = delete;
+
+    ProfileStage stage_;
+
+    // Microseconds since profiling was reset, negative when profiling was disabled at construction
+    long long start_time_;
+  };
+
+  // Attributes the events of the calling thread to frame_index until destruction
+  class ProfileFrameScope {
+
+  public:
+
+    explicit ProfileFrameScope(const long long frame_index);
+
+    ~ProfileFrameScope();
+
+  private:
+
+    ProfileFrameScope(const ProfileFrameScope &) = delete;
+    ProfileFrameScope &operator =(const ProfileFrameScope &) = delete;
+
+    long long previous_frame_index_;
+  };
+
+}
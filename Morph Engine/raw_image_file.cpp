@@ -0,0 +1,110 @@
+#include "raw_image_file.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    RawImageFileHeader MakeRawImageFileHeader(const cv::Size &size, const int type) {
+      RawImageFileHeader header;
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic_, RAW_IMAGE_FILE_MAGIC, sizeof(header.magic_));
+      header.version_ = RAW_IMAGE_FILE_VERSION;
+      header.width_ = size.width;
+      header.height_ = size.height;
+      header.type_ = type;
+      return header;
+    }
+
+  }
+
+  bool MappedRawImage::Open(const std::string &file_path) {
+    Close();
+
+    if (!mapped_file_.Open(file_path)) {
+      return false;
+    }
+
+    RawImageFileHeader header;
+    if (mapped_file_.size() < sizeof(header)) {
+      Close();
+      return false;
+    }
+    std::memcpy(&header, mapped_file_.data(), sizeof(header));
+
+    if (std::memcmp(header.magic_, RAW_IMAGE_FILE_MAGIC, sizeof(header.magic_)) || header.version_ != RAW_IMAGE_FILE_VERSION ||
+      header.width_ <= 0 || header.height_ <= 0 || CV_ELEM_SIZE(header.type_) <= 0) {
+      Close();
+      return false;
+    }
+
+    size_ = cv::Size(header.width_, header.height_);
+    type_ = header.type_;
+
+    if ((mapped_file_.size() - sizeof(header)) / RowStep() < (size_t)size_.height) {
+      Close();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool MappedRawImage::Create(const std::string &file_path, const cv::Size &size, const int type) {
+    Close();
+
+    if (size.width <= 0 || size.height <= 0) {
+      return false;
+    }
+
+    const RawImageFileHeader header = MakeRawImageFileHeader(size, type);
+
+    if (!mapped_file_.Create(file_path, sizeof(header) + (size_t)size.height * size.width * CV_ELEM_SIZE(type))) {
+      return false;
+    }
+
+    std::memcpy(mapped_file_.writable_data(), &header, sizeof(header));
+
+    size_ = size;
+    type_ = type;
+
+    return true;
+  }
+
+  cv::Mat MappedRawImage::Region(const cv::Rect &rect) const {
+    const char *pixels = mapped_file_.data() + sizeof(RawImageFileHeader) + (size_t)rect.y * RowStep() + (size_t)rect.x * CV_ELEM_SIZE(type_);
+    return cv::Mat(rect.height, rect.width, type_, (void *)pixels, RowStep());
+  }
+
+  bool MappedRawImage::Flush(const cv::Rect &rect) {
+    if (!rect.height) {
+      return true;
+    }
+    return mapped_file_.Flush(sizeof(RawImageFileHeader) + (size_t)rect.y * RowStep(), (size_t)rect.height * RowStep());
+  }
+
+  bool IsRawImageFile(const std::string &file_path) {
+    std::ifstream input_stream(file_path, std::ios::binary);
+
+    char magic[sizeof(RAW_IMAGE_FILE_MAGIC)];
+    return input_stream.read(magic, sizeof(magic)) && !std::memcmp(magic, RAW_IMAGE_FILE_MAGIC, sizeof(magic));
+  }
+
+  bool SaveRawImage(const std::string &file_path, const cv::Mat &image) {
+    std::ofstream output_stream(file_path, std::ios::binary);
+    if (!output_stream) {
+      return false;
+    }
+
+    const RawImageFileHeader header = MakeRawImageFileHeader(image.size(), image.type());
+    output_stream.write((const char *)&header, sizeof(header));
+
+    for (int r = 0; r < image.rows; ++r) {
+      output_stream.write((const char *)image.ptr(r), image.cols * image.elemSize());
+    }
+
+    return (bool)output_stream;
+  }
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "memory_mapped_file.h"
+
+namespace ImageMorphing {
+
+  // Raw image file, little endian: RawImageFileHeader, then the rows of pixels packed one after another
+  const char RAW_IMAGE_FILE_MAGIC[4] = {'M', 'R', 'I', 'M'};
+  const uint32_t RAW_IMAGE_FILE_VERSION = 1;
+
+  const std::string RAW_IMAGE_FILE_EXTENSION = ".mri";
+
+  struct RawImageFileHeader {
+    char magic_[4];
+    uint32_t version_;
+    int32_t width_;
+    int32_t height_;
+    // OpenCV type of the pixels, such as CV_8UC3
+    int32_t type_;
+    uint32_t reserved_[3];
+  };
+
+  // Image kept in a memory-mapped raw image file. Regions are views into the mapping, so an image much larger
+  // than the memory can be read and written piece by piece.
+  class MappedRawImage {
+
+  public:
+
+    MappedRawImage() : type_(0) {
+    }
+
+    bool Open(const std::string &file_path);
+
+    bool Create(const std::string &file_path, const cv::Size &size, const int type);
+
+    void Close() {
+      mapped_file_.Close();
+      size_ = cv::Size();
+    }
+
+    bool IsOpen() const {
+      return mapped_file_.IsOpen();
+    }
+
+    cv::Size size() const {
+      return size_;
+    }
+
+    int type() const {
+      return type_;
+    }
+
+    // View of rect, valid until Close. Views of an image opened read-only must not be written.
+    cv::Mat Region(const cv::Rect &rect) const;
+
+    // Writes the rows of rect back to the file, the OS would otherwise do it whenever it sees fit
+    bool Flush(const cv::Rect &rect);
+
+  private:
+
+    MappedRawImage(const MappedRawImage &) = delete;
+    MappedRawImage &operator =(const MappedRawImage &) = delete;
+
+    size_t RowStep() const {
+      return size_.width * CV_ELEM_SIZE(type_);
+    }
+
+    MemoryMappedFile mapped_file_;
+
+    cv::Size size_;
+    int type_;
+  };
+
+  bool IsRawImageFile(const std::string &file_path);
+
+  // Writes image to a raw image file without mapping it
+  bool SaveRawImage(const std::string &file_path, const cv::Mat &image);
+
+}
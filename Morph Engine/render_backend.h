@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "grid_mesh.h"
+#include "texture_filter.h"
+
+namespace ImageMorphing {
+
+  // Draws an image mapped onto a grid mesh whose vertices were moved to their warped positions.
+  // The warped image has the type of the source, pixels outside of the mesh are black, or transparent for BGRA.
+  class RenderBackend {
+
+  public:
+
+    virtual ~RenderBackend() {
+    }
+
+    virtual cv::Mat Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+      const TextureFilter texture_filter) = 0;
+
+    // Same as above, drawing into warped_image. It is only reallocated when its size or type differ from source_image,
+    // so it may be a cv::Mat header over memory of the caller, with any row step.
+    virtual void Render(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+      const TextureFilter texture_filter, cv::Mat &warped_image) {
+      warped_image.create(source_image.size(), source_image.type());
+      Render(source_image, grid_mesh, warped_vertices, texture_filter).copyTo(warped_image);
+    }
+
+    // Same as calling Render for every entry of warped_vertices_batch
+    std::vector<cv::Mat> RenderBatch(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<std::vector<glm::vec2> > &warped_vertices_batch,
+      const TextureFilter texture_filter) {
+      std::vector<cv::Mat> warped_images;
+      RenderBatch(source_image, grid_mesh, warped_vertices_batch, texture_filter, warped_images);
+      return warped_images;
+    }
+
+    // Same as above, replacing the images of warped_images, which keeps its capacity from batch to batch.
+    // Backends override this one when they can share the work.
+    virtual void RenderBatch(const cv::Mat &source_image, const GridMesh &grid_mesh, const std::vector<std::vector<glm::vec2> > &warped_vertices_batch,
+      const TextureFilter texture_filter, std::vector<cv::Mat> &warped_images) {
+      warped_images.clear();
+      for (const auto &warped_vertices : warped_vertices_batch) {
+        warped_images.push_back(Render(source_image, grid_mesh, warped_vertices, texture_filter));
+      }
+    }
+  };
+
+}
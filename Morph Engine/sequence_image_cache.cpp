@@ -0,0 +1,171 @@
+#include "sequence_image_cache.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace ImageMorphing {
+
+  namespace {
+
+    struct CachedImage {
+
+      CachedImage() : pin_count_(0), is_resident_(false), is_loading_(false) {
+      }
+
+      cv::Mat image_;
+      size_t pin_count_;
+
+      // Resident images count against the budget, including the ones still being loaded
+      bool is_resident_;
+      bool is_loading_;
+    };
+
+  }
+
+  struct SequenceImageCache::State {
+
+    State(const size_t image_count) : cached_images_(image_count), resident_count_(0) {
+    }
+
+    std::mutex mutex_;
+
+    // Signaled whenever an image finished loading or got unpinned
+    std::condition_variable changed_;
+
+    std::vector<CachedImage> cached_images_;
+    size_t resident_count_;
+  };
+
+  SequenceImageCache::SequenceImageCache(const size_t image_count, const LoadFunction &load_image, const size_t max_resident_images)
+    : max_resident_images_(max_resident_images ? std::max<size_t>(2, max_resident_images) : 0), state_(new State(image_count)), load_image_(load_image) {
+  }
+
+  SequenceImageCache::~SequenceImageCache() {
+  }
+
+  void SequenceImageCache::AcquireSegment(const size_t segment_index, cv::Mat &source_image, cv::Mat &destination_image) {
+    const size_t image_indices[2] = {segment_index, segment_index + 1};
+
+    std::vector<CachedImage> &cached_images = state_->cached_images_;
+
+    std::unique_lock<std::mutex> lock(state_->mutex_);
+
+    // Wait for room, then reserve it and pin both images at once, so a waiting worker never holds a pin
+    for (;;) {
+      size_t needed_count = 0;
+      for (const size_t image_index : image_indices) {
+        needed_count += !cached_images[image_index].is_resident_;
+      }
+
+      if (!max_resident_images_ || state_->resident_count_ + needed_count <= max_resident_images_) {
+        break;
+      }
+
+      size_t excess_count = state_->resident_count_ + needed_count - max_resident_images_;
+
+      std::vector<size_t> evictable_indices;
+      for (size_t image_index = 0; image_index < cached_images.size() && evictable_indices.size() < excess_count; ++image_index) {
+        const CachedImage &cached_image = cached_images[image_index];
+        if (cached_image.is_resident_ && !cached_image.is_loading_ && !cached_image.pin_count_ && image_index != image_indices[0] && image_index != image_indices[1]) {
+          evictable_indices.push_back(image_index);
+        }
+      }
+
+      if (evictable_indices.size() == excess_count) {
+        for (const size_t image_index : evictable_indices) {
+          cached_images[image_index].image_.release();
+          cached_images[image_index].is_resident_ = false;
+          --state_->resident_count_;
+        }
+        break;
+      }
+
+      state_->changed_.wait(lock);
+    }
+
+    std::vector<size_t> loading_indices;
+
+    for (const size_t image_index : image_indices) {
+      CachedImage &cached_image = cached_images[image_index];
+      ++cached_image.pin_count_;
+
+      if (!cached_image.is_resident_) {
+        cached_image.is_resident_ = true;
+        cached_image.is_loading_ = true;
+        ++state_->resident_count_;
+        loading_indices.push_back(image_index);
+      }
+    }
+
+    // Decode outside of the lock, other workers keep going meanwhile
+    if (!loading_indices.empty()) {
+      lock.unlock();
+
+      std::vector<cv::Mat> loaded_images;
+      try {
+        for (const size_t image_index : loading_indices) {
+          loaded_images.push_back(load_image_(image_index));
+        }
+      } catch (...) {
+        // Gives back the room and the pins, so the workers waiting on these images do not wait forever
+        lock.lock();
+
+        for (const size_t image_index : loading_indices) {
+          cached_images[image_index].is_loading_ = false;
+          cached_images[image_index].is_resident_ = false;
+          --state_->resident_count_;
+        }
+
+        for (const size_t image_index : image_indices) {
+          --cached_images[image_index].pin_count_;
+        }
+
+        lock.unlock();
+        state_->changed_.notify_all();
+        throw;
+      }
+
+      lock.lock();
+
+      for (size_t i = 0; i < loading_indices.size(); ++i) {
+        cached_images[loading_indices[i]].image_ = loaded_images[i];
+        cached_images[loading_indices[i]].is_loading_ = false;
+      }
+
+      state_->changed_.notify_all();
+    }
+
+    // Another worker may still be loading one of them
+    state_->changed_.wait(lock, [&] {
+      return !cached_images[image_indices[0]].is_loading_ && !cached_images[image_indices[1]].is_loading_;
+    });
+
+    // The worker loading one of them failed, so it is loaded again
+    if (!cached_images[image_indices[0]].is_resident_ || !cached_images[image_indices[1]].is_resident_) {
+      for (const size_t image_index : image_indices) {
+        --cached_images[image_index].pin_count_;
+      }
+
+      lock.unlock();
+      state_->changed_.notify_all();
+
+      AcquireSegment(segment_index, source_image, destination_image);
+      return;
+    }
+
+    source_image = cached_images[image_indices[0]].image_;
+    destination_image = cached_images[image_indices[1]].image_;
+  }
+
+  void SequenceImageCache::ReleaseSegment(const size_t segment_index) {
+    {
+      std::lock_guard<std::mutex> lock(state_->mutex_);
+      --state_->cached_images_[segment_index].pin_count_;
+      --state_->cached_images_[segment_index + 1].pin_count_;
+    }
+    state_->changed_.notify_all();
+  }
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <opencv2/core.hpp>
+
+namespace ImageMorphing {
+
+  // Loads the images of a sequence on demand and keeps at most max_resident_images_ of them in memory.
+  // Workers pin the two images of the segment they morph; unpinned images are dropped, lowest index first,
+  // when another one needs the room. Safe to use from several threads.
+  class SequenceImageCache {
+
+  public:
+
+    typedef std::function<cv::Mat(const size_t image_index)> LoadFunction;
+
+    // A max_resident_images of 0 keeps every image once loaded, otherwise at least the two images of a segment are allowed
+    SequenceImageCache(const size_t image_count, const LoadFunction &load_image, const size_t max_resident_images);
+
+    ~SequenceImageCache();
+
+    // Blocks until images segment_index and segment_index + 1 are loaded, they stay resident until ReleaseSegment.
+    // When load_image throws, nothing stays pinned and the exception is passed on.
+    void AcquireSegment(const size_t segment_index, cv::Mat &source_image, cv::Mat &destination_image);
+
+    void ReleaseSegment(const size_t segment_index);
+
+    size_t max_resident_images_;
+
+  private:
+
+    SequenceImageCache(const SequenceImageCache &) = delete;
+    SequenceImageCache &operator =(const SequenceImageCache &) = delete;
+
+    // Keeps <mutex> and <condition_variable> out of the header, which code compiled with /clr cannot include
+    struct State;
+
+    std::unique_ptr<State> state_;
+
+    LoadFunction load_image_;
+  };
+
+  // Holds the images of a segment of image_cache, and releases the segment when it goes out of scope, also when morphing throws
+  class AcquiredSegment {
+
+  public:
+
+    AcquiredSegment(SequenceImageCache &image_cache, const size_t segment_index) : image_cache_(image_cache), segment_index_(segment_index) {
+      image_cache_.AcquireSegment(segment_index_, source_image_, destination_image_);
+    }
+
+    ~AcquiredSegment() {
+      source_image_.release();
+      destination_image_.release();
+      image_cache_.ReleaseSegment(segment_index_);
+    }
+
+    cv::Mat source_image_;
+    cv::Mat destination_image_;
+
+  private:
+
+    AcquiredSegment(const AcquiredSegment &) = delete;
+    AcquiredSegment &operator =(const AcquiredSegment &) = delete;
+
+    SequenceImageCache &image_cache_;
+    const size_t segment_index_;
+  };
+
+}
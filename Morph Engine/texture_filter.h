@@ -0,0 +1,14 @@
+#pragma once
+
+namespace ImageMorphing {
+
+  enum class TextureFilter {
+    NEAREST,
+    BILINEAR,
+    // Bilinear within the two closest mipmap levels, for warps which shrink parts of the image
+    TRILINEAR,
+    // Trilinear plus anisotropic filtering, for warps which shrink the image much more in one direction
+    ANISOTROPIC
+  };
+
+}
@@ -0,0 +1,105 @@
+#include "tiled_warping.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cpu_render_backend.h"
+#include "profiler.h"
+
+namespace ImageMorphing {
+
+  namespace {
+
+    // Bilinear filtering reads the pixel after the sample, and the sampler treats the last row and column of a region as the border
+    const int SOURCE_RECT_MARGIN = 2;
+
+  }
+
+  std::vector<WarpTile> ComputeWarpTiles(const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices, const int tile_size) {
+    const cv::Size image_size = grid_mesh.image_size_;
+    const cv::Rect image_rect(cv::Point(0, 0), image_size);
+
+    const int tile_column_count = (image_size.width + tile_size - 1) / tile_size;
+    const int tile_row_count = (image_size.height + tile_size - 1) / tile_size;
+
+    std::vector<WarpTile> tiles(tile_column_count * tile_row_count);
+
+    for (int tile_row = 0; tile_row < tile_row_count; ++tile_row) {
+      for (int tile_column = 0; tile_column < tile_column_count; ++tile_column) {
+        tiles[tile_row * tile_column_count + tile_column].rect_ = cv::Rect(tile_column * tile_size, tile_row * tile_size, tile_size, tile_size) & image_rect;
+      }
+    }
+
+    const int triangle_count = grid_mesh.indices_.size() / 3;
+
+    for (int triangle_index = 0; triangle_index < triangle_count; ++triangle_index) {
+      cv::Point2d positions[3];
+      cv::Point2d source_positions[3];
+
+      WarpedTrianglePositions(grid_mesh, warped_vertices, triangle_index, positions, source_positions);
+
+      double min_x = std::min(positions[0].x, std::min(positions[1].x, positions[2].x));
+      double max_x = std::max(positions[0].x, std::max(positions[1].x, positions[2].x));
+      double min_y = std::min(positions[0].y, std::min(positions[1].y, positions[2].y));
+      double max_y = std::max(positions[0].y, std::max(positions[1].y, positions[2].y));
+
+      // Same pixel range as the rasterizer, pixel (c, r) is sampled at its center
+      int first_column = std::max(0, (int)std::ceil(min_x - 0.5));
+      int last_column = std::min(image_size.width - 1, (int)std::floor(max_x - 0.5));
+      int first_row = std::max(0, (int)std::ceil(min_y - 0.5));
+      int last_row = std::min(image_size.height - 1, (int)std::floor(max_y - 0.5));
+
+      if (first_column > last_column || first_row > last_row) {
+        continue;
+      }
+
+      double source_min_x = std::min(source_positions[0].x, std::min(source_positions[1].x, source_positions[2].x));
+      double source_max_x = std::max(source_positions[0].x, std::max(source_positions[1].x, source_positions[2].x));
+      double source_min_y = std::min(source_positions[0].y, std::min(source_positions[1].y, source_positions[2].y));
+      double source_max_y = std::max(source_positions[0].y, std::max(source_positions[1].y, source_positions[2].y));
+
+      cv::Rect source_rect(cv::Point((int)std::floor(source_min_x) - SOURCE_RECT_MARGIN, (int)std::floor(source_min_y) - SOURCE_RECT_MARGIN),
+        cv::Point((int)std::ceil(source_max_x) + SOURCE_RECT_MARGIN, (int)std::ceil(source_max_y) + SOURCE_RECT_MARGIN));
+      source_rect &= image_rect;
+
+      for (int tile_row = first_row / tile_size; tile_row <= last_row / tile_size; ++tile_row) {
+        for (int tile_column = first_column / tile_size; tile_column <= last_column / tile_size; ++tile_column) {
+          WarpTile &tile = tiles[tile_row * tile_column_count + tile_column];
+
+          tile.source_rect_ = tile.triangle_indices_.empty() ? source_rect : (tile.source_rect_ | source_rect);
+          tile.triangle_indices_.push_back(triangle_index);
+        }
+      }
+    }
+
+    return tiles;
+  }
+
+  cv::Mat RenderWarpTile(const cv::Mat &source_region, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+    const WarpTile &tile, const TextureFilter texture_filter) {
+    MORPH_PROFILE_SCOPE(ProfileStage::DRAW);
+    MORPH_PROFILE_COUNT(ProfileCounter::DRAWN_TRIANGLES, tile.triangle_indices_.size());
+
+    cv::Mat warped_tile = cv::Mat::zeros(tile.rect_.size(), source_region.type());
+
+    const cv::Point2d offset = tile.rect_.tl();
+    const cv::Point2d source_offset = tile.source_rect_.tl();
+
+    for (const int triangle_index : tile.triangle_indices_) {
+      cv::Point2d positions[3];
+      cv::Point2d source_positions[3];
+
+      WarpedTrianglePositions(grid_mesh, warped_vertices, triangle_index, positions, source_positions);
+
+      for (size_t k = 0; k < 3; ++k) {
+        positions[k] -= offset;
+        source_positions[k] -= source_offset;
+      }
+
+      RasterizeTriangle(source_region, warped_tile, positions, source_positions, texture_filter);
+    }
+
+    return warped_tile;
+  }
+
+}
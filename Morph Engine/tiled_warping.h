@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "grid_mesh.h"
+#include "texture_filter.h"
+
+namespace ImageMorphing {
+
+  // Side of the square output tiles of a tiled warp, in pixels
+  const int DEFAULT_WARP_TILE_SIZE = 1024;
+
+  struct WarpTile {
+
+    // Pixels of the warped image the tile covers
+    cv::Rect rect_;
+
+    // Pixels of the source image the tile samples, including the neighbours bilinear filtering reads
+    cv::Rect source_rect_;
+
+    // Triangles of the grid mesh which cover pixels of the tile
+    std::vector<int> triangle_indices_;
+  };
+
+  // Splits the warped image into tiles and finds, from the warped grid mesh, which part of the source image each one needs.
+  // Tiles no triangle covers stay black and need no source pixel.
+  std::vector<WarpTile> ComputeWarpTiles(const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices, const int tile_size);
+
+  // Renders one tile of the warped image, matching what CPURenderBackend::Render draws there up to rounding on triangle edges.
+  // source_region holds tile.source_rect_ of the source image.
+  cv::Mat RenderWarpTile(const cv::Mat &source_region, const GridMesh &grid_mesh, const std::vector<glm::vec2> &warped_vertices,
+    const WarpTile &tile, const TextureFilter texture_filter);
+
+}
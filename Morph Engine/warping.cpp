@@ -0,0 +1,173 @@
+#include "warping.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <omp.h>
+
+#include "pixel_kernels.h"
+
+namespace ImageMorphing {
+
+  namespace {
+
+    template <typename T, int channel_count>
+    void FieldWarpPixels(const cv::Mat &source_image,
+      const FeatureLineSpan &source_feature_lines,
+      const FeatureLineSpan &destination_feature_lines,
+      const double a, const double b, const double p,
+      cv::Mat &warped_image) {
+      typedef cv::Vec<double, channel_count> Color;
+
+#pragma omp parallel for
+      for (int r = 0; r < warped_image.rows; ++r) {
+        for (int c = 0; c < warped_image.cols; ++c) {
+
+          Color total_warped_color;
+
+          double weight_sum = 0;
+
+          for (size_t i = 0; i < destination_feature_lines.size(); ++i) {
+            cv::Point2d p_x = (cv::Point2d(c, r) - destination_feature_lines[i].first);
+            cv::Point2d p_q = destination_feature_lines[i].second - destination_feature_lines[i].first;
+
+            double u = p_x.ddot(p_q) / SqrLineLength(destination_feature_lines[i]);
+            double v = p_x.ddot(Perpendicular(p_q)) / LineLength(destination_feature_lines[i]);
+
+            cv::Point2d p_q_prime = source_feature_lines[i].second - source_feature_lines[i].first;
+
+            cv::Point2d warped_position = source_feature_lines[i].first + u * p_q_prime + v * Perpendicular(p_q_prime) / LineLength(source_feature_lines[i]);
+
+            double distance_with_line = std::abs(v);
+
+            if (u < 0) {
+              distance_with_line = LineLength(FeatureLine(cv::Point2d(c, r), destination_feature_lines[i].first));
+            }
+
+            if (u > 1) {
+              distance_with_line = LineLength(FeatureLine(cv::Point2d(c, r), destination_feature_lines[i].second));
+            }
+
+            const double line_weight = std::pow(std::pow(LineLength(destination_feature_lines[i]), p) / (a + distance_with_line), b);
+            weight_sum += line_weight;
+
+            Color warped_color;
+
+            warped_position.x = std::max(0.0, warped_position.x);
+            warped_position.x = std::min(source_image.cols - 1.0, warped_position.x);
+
+            warped_position.y = std::max(0.0, warped_position.y);
+            warped_position.y = std::min(source_image.rows - 1.0, warped_position.y);
+
+            warped_color = BilinearSample<T, channel_count>(source_image, warped_position);
+
+            total_warped_color += warped_color * line_weight;
+          }
+
+          total_warped_color /= weight_sum;
+
+          warped_image.at<cv::Vec<T, channel_count> >(r, c) = total_warped_color;
+        }
+      }
+    }
+
+  }
+
+  cv::Mat ImageWarping(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p) {
+    // Every pixel is written, so the buffer does not need the content of the source
+    cv::Mat warped_image(source_image.size(), source_image.type());
+    ImageWarping(source_image, source_feature_lines, destination_feature_lines, a, b, p, warped_image);
+    return warped_image;
+  }
+
+  void ImageWarping(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p,
+    cv::Mat &warped_image) {
+
+    warped_image.create(source_image.size(), source_image.type());
+
+    switch (source_image.type()) {
+    case CV_8UC3:
+      FieldWarpPixels<uchar, 3>(source_image, source_feature_lines, destination_feature_lines, a, b, p, warped_image);
+      break;
+    case CV_8UC4:
+      FieldWarpPixels<uchar, 4>(source_image, source_feature_lines, destination_feature_lines, a, b, p, warped_image);
+      break;
+    case CV_16UC3:
+      FieldWarpPixels<ushort, 3>(source_image, source_feature_lines, destination_feature_lines, a, b, p, warped_image);
+      break;
+    case CV_32FC3:
+      FieldWarpPixels<float, 3>(source_image, source_feature_lines, destination_feature_lines, a, b, p, warped_image);
+      break;
+    }
+  }
+
+  std::vector<glm::vec2> ComputeWarpedGridTargets(const GridMesh &grid_mesh,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p) {
+    std::vector<glm::vec2> target_vertices;
+    ComputeWarpedGridTargets(grid_mesh, source_feature_lines, destination_feature_lines, a, b, p, target_vertices);
+    return target_vertices;
+  }
+
+  void ComputeWarpedGridTargets(const GridMesh &grid_mesh,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p,
+    std::vector<glm::vec2> &target_vertices) {
+
+    const std::vector<glm::vec2> &vertices = grid_mesh.graph_.vertices_;
+
+    target_vertices.resize(vertices.size());
+
+#pragma omp parallel for
+    for (int j = 0; j < (int)vertices.size(); ++j) {
+      const glm::vec2 &vertex = vertices[j];
+
+      double weight_sum = 0;
+      cv::Point2d total_warped_position(0, 0);
+
+      for (size_t i = 0; i < source_feature_lines.size(); ++i) {
+        cv::Point2d p_x = (cv::Point2d(vertex.x, vertex.y) - source_feature_lines[i].first);
+        cv::Point2d p_q = source_feature_lines[i].second - source_feature_lines[i].first;
+
+        double u = p_x.ddot(p_q) / SqrLineLength(source_feature_lines[i]);
+        double v = p_x.ddot(Perpendicular(p_q)) / LineLength(source_feature_lines[i]);
+
+        cv::Point2d p_q_prime = destination_feature_lines[i].second - destination_feature_lines[i].first;
+
+        cv::Point2d warped_position = destination_feature_lines[i].first + u * p_q_prime + v * Perpendicular(p_q_prime) / LineLength(destination_feature_lines[i]);
+
+        double distance_with_line = std::abs(v);
+
+        if (u < 0) {
+          distance_with_line = LineLength(FeatureLine(cv::Point2d(vertex.x, vertex.y), source_feature_lines[i].first));
+        }
+
+        if (u > 1) {
+          distance_with_line = LineLength(FeatureLine(cv::Point2d(vertex.x, vertex.y), source_feature_lines[i].second));
+        }
+
+        double lines_weight = std::pow(std::pow(LineLength(source_feature_lines[i]), p) / (a + distance_with_line), b);
+
+        warped_position.x = std::max(0.0, warped_position.x);
+        warped_position.x = std::min(grid_mesh.image_size_.width - 1.0, warped_position.x);
+
+        warped_position.y = std::max(0.0, warped_position.y);
+        warped_position.y = std::min(grid_mesh.image_size_.height - 1.0, warped_position.y);
+
+        weight_sum += lines_weight;
+        total_warped_position += lines_weight * warped_position;
+      }
+
+      target_vertices[j] = glm::vec2(total_warped_position.x / weight_sum, total_warped_position.y / weight_sum);
+    }
+  }
+
+}
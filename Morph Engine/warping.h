@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <opencv2/core.hpp>
+
+#include "feature_line.h"
+#include "grid_mesh.h"
+
+namespace ImageMorphing {
+
+  // Field warping of [1], evaluated for every pixel of an image of a type IsSupportedImageType accepts
+  cv::Mat ImageWarping(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p);
+
+  // Same as above, writing into warped_image. It is only reallocated when its size or type differ from source_image,
+  // so it may be a buffer reused for a whole sequence or a cv::Mat header over memory of the caller, with any row step.
+  void ImageWarping(const cv::Mat &source_image,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p,
+    cv::Mat &warped_image);
+
+  // Field warping of [1], evaluated only at the vertices of grid_mesh. The lines must be in the coordinates of the mesh.
+  std::vector<glm::vec2> ComputeWarpedGridTargets(const GridMesh &grid_mesh,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p);
+
+  // Same as above, writing into target_vertices so its capacity can be reused from frame to frame
+  void ComputeWarpedGridTargets(const GridMesh &grid_mesh,
+    const FeatureLineSpan &source_feature_lines,
+    const FeatureLineSpan &destination_feature_lines,
+    const double a, const double b, const double p,
+    std::vector<glm::vec2> &target_vertices);
+
+}